@@ -0,0 +1,77 @@
+// C++20 module interface of argh: `import argh;` instead of including argh.h and wargh.h.
+// The headers are compiled once, with the module, instead of in every translation unit using them.
+// See the argh_module target in CMakeLists.txt. The ARGH_ENABLE_* options are on if defined when building it.
+//
+// Experimental: no target or CI job builds it by default, and compiler support for header units in the global
+// module fragment varies. GCC 12, for one, compiles the module but does not let importers see argh::parser.
+
+module;
+
+#include "argh.h"
+#include "wargh.h"
+
+export module argh;
+
+export namespace argh
+{
+   using argh::get_status;
+   using argh::result;
+   using argh::key;
+   using argh::parse_stats;
+   using argh::parser_base;
+
+   using argh::basic_string_stream;
+   using argh::string_stream;
+   using argh::wstring_stream;
+   using argh::make_string_stream;
+   using argh::basic_multimap_iteration_wrapper;
+   using argh::multimap_iteration_wrapper;
+   using argh::wmultimap_iteration_wrapper;
+
+   using argh::flat_multiset;
+   using argh::flat_set;
+   using argh::flat_multimap;
+   using argh::node_storage;
+   using argh::flat_storage;
+   using argh::pooled_storage;
+
+   using argh::basic_parser;
+   using argh::parser;
+   using argh::flat_parser;
+   using argh::view_parser;
+   using argh::flat_view_parser;
+   using argh::pooled_parser;
+   using argh::flat_pooled_parser;
+   using argh::wparser;
+   using argh::wflat_parser;
+   using argh::wview_parser;
+   using argh::wflat_view_parser;
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+   using argh::pmr_storage;
+   using argh::pmr_flat_storage;
+   using argh::counting_resource;
+   using argh::pmr_parser;
+   using argh::pmr_flat_parser;
+   using argh::pmr_wparser;
+#endif
+
+   using argh::incremental_parser;
+   using argh::basic_overlay;
+   using argh::visit;
+   using argh::param_names;
+   using argh::serial_executor;
+#if defined(ARGH_ENABLE_THREADS)
+   using argh::thread_executor;
+#endif
+   using argh::default_executor;
+   using argh::parsed_batch;
+   using argh::parse_batch;
+   using argh::frozen_parser;
+
+   using argh::static_option;
+   using argh::static_flag;
+   using argh::static_param;
+   using argh::static_key;
+   using argh::static_parser;
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#define ARGH_H_INCLUDED 1
+
+#include "argh_fwd.h"
+
 #include <algorithm>
 #include <sstream>
 #include <limits>
@@ -7,7 +11,49 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <memory>
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cctype>
+#include <type_traits>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <exception>
+
+// Parts of argh that need more headers are opt-in, so that every translation unit does not pay for them:
+// - ARGH_ENABLE_THREADS: argh::thread_executor, the default executor of parse_batch() then (C++17, <thread>)
+// - ARGH_ENABLE_PMR: argh::pmr_parser, pmr_flat_parser, pmr_wparser and counting_resource (C++17, <memory_resource>)
+// - ARGH_ENABLE_MMAP: response files and sources are memory-mapped on POSIX systems, instead of read with <cstdio>
+#if defined(ARGH_HAS_STRING_VIEW)
+#include <charconv>
+#include <array>
+#if defined(ARGH_ENABLE_THREADS)
+#include <atomic>
+#include <thread>
+#endif
+#if defined(ARGH_ENABLE_PMR) && __has_include(<memory_resource>)
+#define ARGH_HAS_MEMORY_RESOURCE 1
+#include <memory_resource>
+#endif
+#endif
+
+// Define ARGH_ENABLE_STATS to count what the parsers do, see parser::stats(). Without it, nothing is counted.
+#if defined(ARGH_ENABLE_STATS)
+#define ARGH_STATS(...) __VA_ARGS__
+#else
+#define ARGH_STATS(...)
+#endif
+
+#if defined(ARGH_ENABLE_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define ARGH_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace argh
 {
@@ -19,22 +65,24 @@ namespace argh
    //    2.2: Parameters: a name followed by a non-option value
 
 #if !defined(__GNUC__) || (__GNUC__ >= 5)
-   using string_stream = std::istringstream;
+   template<typename Char, typename Traits = std::char_traits<Char>>
+   using basic_string_stream = std::basic_istringstream<Char, Traits>;
 #else
     // Until GCC 5, istringstream did not have a move constructor.
     // stringstream_proxy is used instead, as a workaround.
-   class stringstream_proxy
+   template<typename Char, typename Traits = std::char_traits<Char>>
+   class basic_stringstream_proxy
    {
    public:
-      stringstream_proxy() = default;
+      basic_stringstream_proxy() = default;
 
       // Construct with a value.
-      stringstream_proxy(std::string const& value) :
+      basic_stringstream_proxy(std::basic_string<Char, Traits> const& value) :
          stream_(value)
       {}
 
       // Copy constructor.
-      stringstream_proxy(const stringstream_proxy& other) :
+      basic_stringstream_proxy(const basic_stringstream_proxy& other) :
          stream_(other.stream_.str())
       {
          stream_.setstate(other.stream_.rdstate());
@@ -46,7 +94,7 @@ namespace argh
       // If the conversion was not possible, the stream will enter the fail state,
       // and operator bool will return false.
       template<typename T>
-      stringstream_proxy& operator >> (T& thing)
+      basic_stringstream_proxy& operator >> (T& thing)
       {
          stream_ >> thing;
          return *this;
@@ -54,244 +102,5249 @@ namespace argh
 
 
       // Get the string value.
-      std::string str() const { return stream_.str(); }
+      std::basic_string<Char, Traits> str() const { return stream_.str(); }
 
-      std::stringbuf* rdbuf() const { return stream_.rdbuf(); }
+      std::basic_stringbuf<Char, Traits>* rdbuf() const { return stream_.rdbuf(); }
 
       // Check the state of the stream.
       // False when the most recent stream operation failed
       explicit operator bool() const { return !!stream_; }
 
-      ~stringstream_proxy() = default;
+      ~basic_stringstream_proxy() = default;
+   private:
+      std::basic_istringstream<Char, Traits> stream_;
+   };
+   using stringstream_proxy = basic_stringstream_proxy<char>;
+
+   template<typename Char, typename Traits = std::char_traits<Char>>
+   using basic_string_stream = basic_stringstream_proxy<Char, Traits>;
+#endif
+
+   using string_stream = basic_string_stream<char>;
+
+   inline string_stream make_string_stream(std::string const& value)
+   {
+      return string_stream(value);
+   }
+
+   template<typename Char, typename Traits, typename Alloc>
+   basic_string_stream<Char, Traits> make_string_stream(std::basic_string<Char, Traits, Alloc> const& value)
+   {
+      return basic_string_stream<Char, Traits>(std::basic_string<Char, Traits>(value.data(), value.size()));
+   }
+
+#if defined(ARGH_HAS_STRING_VIEW)
+   inline string_stream make_string_stream(std::string_view value)
+   {
+      return string_stream(std::string(value));
+   }
+
+   template<typename Char, typename Traits>
+   basic_string_stream<Char, Traits> make_string_stream(std::basic_string_view<Char, Traits> value)
+   {
+      return basic_string_stream<Char, Traits>(std::basic_string<Char, Traits>(value));
+   }
+#endif
+
+   namespace detail
+   {
+      // Returns true if [first, last) starts with a decimal number, i.e. if `std::istream >> double` would succeed on it.
+      // A hand-written scanner: no stream, no locale, no allocation.
+      template<typename Char>
+      bool starts_with_number(Char const* first, Char const* last)
+      {
+         auto is_digit = [](Char c) { return '0' <= c && c <= '9'; };
+
+         if (first != last && ('-' == *first || '+' == *first))
+            ++first;
+
+         bool has_mantissa = false;
+         for (; first != last && is_digit(*first); ++first)
+            has_mantissa = true;
+         if (first != last && '.' == *first)
+            for (++first; first != last && is_digit(*first); ++first)
+               has_mantissa = true;
+         if (!has_mantissa)
+            return false;
+
+         // an exponent, once started, must have digits
+         if (first == last || ('e' != *first && 'E' != *first))
+            return true;
+         ++first;
+         if (first != last && ('-' == *first || '+' == *first))
+            ++first;
+         return first != last && is_digit(*first);
+      }
+
+      //////////////////////////////////////////////////////////////////////////
+      // Conversion of an arg to a typed value, used by parser::get<T>().
+      // The whole arg must be consumed for the conversion to succeed.
+
+      struct integer_conversion {};
+      struct bool_conversion {};
+      struct floating_conversion {};
+      struct string_conversion {};
+      struct stream_conversion {};
+
+      template<typename T>
+      struct is_char_type : std::integral_constant<bool,
+         std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value ||
+         std::is_same<T, wchar_t>::value || std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value>
+      {};
+
+      template<typename T>
+      struct is_string_type : std::false_type {};
+
+      template<typename Char, typename Traits, typename Alloc>
+      struct is_string_type<std::basic_string<Char, Traits, Alloc>> : std::true_type {};
+
+#if defined(ARGH_HAS_STRING_VIEW)
+      template<typename Char, typename Traits>
+      struct is_string_type<std::basic_string_view<Char, Traits>> : std::true_type {};
+#endif
+
+      // characters are read with operator>>, as before, since `cmdl("c") >> c` reads a char, not a number
+      template<typename T>
+      using conversion_for = typename std::conditional<std::is_same<T, bool>::value, bool_conversion,
+                             typename std::conditional<std::is_integral<T>::value && !is_char_type<T>::value, integer_conversion,
+                             typename std::conditional<std::is_floating_point<T>::value, floating_conversion,
+                             typename std::conditional<is_string_type<T>::value, string_conversion,
+                                                       stream_conversion>::type>::type>::type>::type;
+
+      template<typename Char, typename T>
+      bool convert(Char const* first, Char const* last, T& value, integer_conversion)
+      {
+         using unsigned_t = typename std::make_unsigned<T>::type;
+
+         bool negative = false;
+         if (first != last && ('-' == *first || '+' == *first))
+            negative = '-' == *first++;
+         if (first == last || (negative && !std::is_signed<T>::value))
+            return false;
+
+         // the magnitude of the most negative value is one more than the max
+         auto const limit = static_cast<unsigned_t>(static_cast<unsigned_t>(std::numeric_limits<T>::max()) + (negative ? 1u : 0u));
+         unsigned_t magnitude = 0;
+         for (; first != last; ++first)
+         {
+            if (*first < '0' || '9' < *first)
+               return false;
+            auto const digit = static_cast<unsigned_t>(*first - '0');
+            if (magnitude > (limit - digit) / 10u)
+               return false; // overflow
+            magnitude = static_cast<unsigned_t>(magnitude * 10u + digit);
+         }
+
+         if (negative && magnitude)
+            value = static_cast<T>(-static_cast<T>(magnitude - 1u) - 1);
+         else
+            value = static_cast<T>(magnitude);
+         return true;
+      }
+
+      template<typename Char, typename T>
+      bool convert(Char const* first, Char const* last, T& value, bool_conversion)
+      {
+         auto const size = static_cast<size_t>(last - first);
+         auto matches = [&](char const* word, size_t word_size) { return size == word_size && std::equal(first, last, word); };
+
+         if (matches("1", 1) || matches("true", 4))
+            value = true;
+         else if (matches("0", 1) || matches("false", 5))
+            value = false;
+         else
+            return false;
+         return true;
+      }
+
+      inline float  strto(char const* str, char** end, float)       { return std::strtof(str, end);  }
+      inline double strto(char const* str, char** end, double)      { return std::strtod(str, end);  }
+      inline long double strto(char const* str, char** end, long double) { return std::strtold(str, end); }
+
+      template<typename T>
+      bool convert(char const* first, char const* last, T& value, floating_conversion)
+      {
+         // like operator>>, accept a leading '+' and no leading whitespace
+         if (first != last && '+' == *first && last - first > 1 && '-' != first[1])
+            ++first;
+         if (first == last || ' ' == *first || ('\t' <= *first && *first <= '\r'))
+            return false;
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+         auto const res = std::from_chars(first, last, value);
+         return std::errc() == res.ec && last == res.ptr;
+#else
+         // strto*() needs a null-terminated string
+         char buffer[64];
+         std::string long_arg;
+         char const* str = buffer;
+         auto const size = static_cast<size_t>(last - first);
+         if (size < sizeof(buffer))
+         {
+            std::copy(first, last, buffer);
+            buffer[size] = '\0';
+         }
+         else
+         {
+            long_arg.assign(first, last);
+            str = long_arg.c_str();
+         }
+
+         char* end = nullptr;
+         errno = 0;
+         value = strto(str, &end, T());
+         return ERANGE != errno && str + size == end;
+#endif
+      }
+
+      // wider chars: a number is all ASCII, so it is narrowed and converted as chars
+      template<typename Char, typename T>
+      bool convert(Char const* first, Char const* last, T& value, floating_conversion)
+      {
+         char buffer[64];
+         std::string long_arg;
+         char* narrow = buffer;
+         auto const size = static_cast<size_t>(last - first);
+         if (sizeof(buffer) < size)
+         {
+            long_arg.resize(size);
+            narrow = &long_arg[0];
+         }
+         for (auto c = first; c != last; ++c)
+         {
+            if (0x7f <= static_cast<unsigned long>(*c) - 1u) // not in [1, 0x7f]
+               return false;
+            narrow[c - first] = static_cast<char>(*c);
+         }
+         return convert(static_cast<char const*>(narrow), static_cast<char const*>(narrow + size), value, floating_conversion());
+      }
+
+      template<typename Char, typename T>
+      bool convert(Char const* first, Char const* last, T& value, string_conversion)
+      {
+         value = T(first, static_cast<size_t>(last - first));
+         return true;
+      }
+
+      template<typename Char, typename T>
+      bool convert(Char const* first, Char const* last, T& value, stream_conversion)
+      {
+         std::basic_istringstream<Char> istr(std::basic_string<Char>(first, last));
+         istr >> value;
+         return !istr.fail();
+      }
+
+      template<typename Char, typename T>
+      bool convert(Char const* first, Char const* last, T& value)
+      {
+         return convert(first, last, value, conversion_for<T>());
+      }
+
+      // The string type owning the characters of String, used for registered param names
+      template<typename String>
+      struct owning_string { using type = String; };
+
+#if defined(ARGH_HAS_STRING_VIEW)
+      template<typename Char, typename Traits>
+      struct owning_string<std::basic_string_view<Char, Traits>> { using type = std::basic_string<Char, Traits>; };
+#endif
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   enum class get_status { OK, MISSING, BAD_CONVERSION };
+
+   // The result of a typed get<T>(): the value, or the reason there is none.
+   template<typename T>
+   class result
+   {
+   public:
+      result(get_status status) : status_(status), value_() {}
+      result(T value) : status_(get_status::OK), value_(std::move(value)) {}
+
+      // Check the state of the result.
+      // False when the arg was missing or could not be converted
+      explicit operator bool() const { return has_value(); }
+      bool has_value()             const { return get_status::OK == status_; }
+      get_status status()          const { return status_; }
+
+      T const& value()      const { assert(has_value()); return value_; }
+      T const& operator*()  const { return value(); }
+      T const* operator->() const { return &value(); }
+
+      template<typename U>
+      T value_or(U&& def_val) const { return has_value() ? value_ : static_cast<T>(std::forward<U>(def_val)); }
+
+   private:
+      get_status status_;
+      T value_;
+   };
+
+   template<typename Container>
+   class basic_multimap_iteration_wrapper
+   {
+   public:
+      using container_t = Container;
+      using iterator_t = typename container_t::const_iterator;
+      using difference_t = typename container_t::difference_type;
+      explicit basic_multimap_iteration_wrapper(const iterator_t& lb, const iterator_t& ub)
+         : lb_(lb)
+         , ub_(ub)
+      {}
+
+      iterator_t begin() const { return lb_; }
+      iterator_t end() const { return ub_; }
+      difference_t size() const { return std::distance(lb_, ub_); }
+
    private:
-      std::istringstream stream_;
+      iterator_t lb_;
+      iterator_t ub_;
+   };
+
+#if !defined(ARGH_WIDE_MULTIMAP_ITERATION_WRAPPER)
+   // the params of a parser, see wargh.h for the wide one
+   using multimap_iteration_wrapper = basic_multimap_iteration_wrapper<std::multimap<std::string, std::string>>;
+#endif
+
+   //////////////////////////////////////////////////////////////////////////
+   // Flat containers: sorted vectors with the lookup interface of std::multiset, std::multimap and std::set.
+   // Elements are contiguous, so small containers are faster to search and cheaper to build than trees.
+   // Equal keys keep their insertion order, as in the std:: containers. The multi containers can also be filled
+   // with append(), then sorted once with sort(): this is how the parsers fill them, in O(n log n) per parse.
+
+   namespace detail
+   {
+      struct key_is_value
+      {
+         template<typename T>
+         T const& operator()(T const& value) const { return value; }
+      };
+
+      struct key_is_first
+      {
+         template<typename Pair>
+         typename Pair::first_type const& operator()(Pair const& value) const { return value.first; }
+      };
+
+      template<typename Value, typename KeyOf, typename Compare, typename Allocator>
+      class sorted_vector
+      {
+      public:
+         using value_type = Value;
+         using allocator_type = Allocator;
+         using container_t = std::vector<Value, Allocator>;
+         // elements are immutable, as in the std:: associative containers
+         using iterator = typename container_t::const_iterator;
+         using const_iterator = typename container_t::const_iterator;
+         using size_type = typename container_t::size_type;
+         using difference_type = typename container_t::difference_type;
+
+         sorted_vector() = default;
+         explicit sorted_vector(Allocator const& alloc) : data_(alloc) {}
+
+         const_iterator begin()  const { return data_.cbegin(); }
+         const_iterator end()    const { return data_.cend();   }
+         const_iterator cbegin() const { return data_.cbegin(); }
+         const_iterator cend()   const { return data_.cend();   }
+         size_type size()        const { return data_.size();   }
+         size_type capacity()    const { return data_.capacity(); }
+         bool empty()            const { return data_.empty();  }
+
+         void clear() { data_.clear(); }
+         void reserve(size_type n) { data_.reserve(n); }
+
+         // moves the elements out to spares, then clears
+         template<typename Spares>
+         void clear_into(Spares& spares)
+         {
+            std::move(data_.begin(), data_.end(), std::back_inserter(spares));
+            data_.clear();
+         }
+
+         template<typename K>
+         const_iterator lower_bound(K const& key) const
+         {
+            return std::lower_bound(begin(), end(), key, [this](Value const& value, K const& k) { return comp_(KeyOf()(value), k); });
+         }
+
+         template<typename K>
+         const_iterator upper_bound(K const& key) const
+         {
+            return std::upper_bound(begin(), end(), key, [this](K const& k, Value const& value) { return comp_(k, KeyOf()(value)); });
+         }
+
+         template<typename K>
+         std::pair<const_iterator, const_iterator> equal_range(K const& key) const
+         {
+            return { lower_bound(key), upper_bound(key) };
+         }
+
+         template<typename K>
+         const_iterator find(K const& key) const
+         {
+            auto it = lower_bound(key);
+            return (end() == it || comp_(key, KeyOf()(*it))) ? end() : it;
+         }
+
+         template<typename K>
+         size_type count(K const& key) const
+         {
+            auto range = equal_range(key);
+            return static_cast<size_type>(std::distance(range.first, range.second));
+         }
+
+         // sorts the elements appended since the last sort, equal keys in the order they were appended.
+         // Args often arrive in order, so there is usually nothing to move.
+         void sort()
+         {
+            auto const less = [this](Value const& a, Value const& b) { return comp_(KeyOf()(a), KeyOf()(b)); };
+            if (!std::is_sorted(data_.begin(), data_.end(), less))
+               std::stable_sort(data_.begin(), data_.end(), less);
+         }
+
+         friend bool operator==(sorted_vector const& lhs, sorted_vector const& rhs) { return lhs.data_ == rhs.data_; }
+         friend bool operator!=(sorted_vector const& lhs, sorted_vector const& rhs) { return lhs.data_ != rhs.data_; }
+
+      protected:
+         // constructed in place at the end, with the container's allocator: the container is not searchable
+         // until it is sorted again
+         template<typename... Args>
+         void emplace_back(Args&&... args)
+         {
+            data_.emplace_back(std::forward<Args>(args)...);
+         }
+
+         // Elements are constructed in place at the end, with the container's allocator, then rotated into place
+         // after any equal keys. Args often arrive in order, so there is usually nothing to rotate.
+         template<typename... Args>
+         const_iterator emplace_equal(Args&&... args)
+         {
+            data_.emplace_back(std::forward<Args>(args)...);
+            auto last = std::prev(data_.end());
+            auto pos = std::upper_bound(data_.begin(), last, *last,
+                                        [this](Value const& a, Value const& b) { return comp_(KeyOf()(a), KeyOf()(b)); });
+            std::rotate(pos, last, data_.end());
+            return pos;
+         }
+
+         template<typename... Args>
+         std::pair<const_iterator, bool> emplace_unique(Args&&... args)
+         {
+            data_.emplace_back(std::forward<Args>(args)...);
+            auto last = std::prev(data_.end());
+            auto pos = std::lower_bound(data_.begin(), last, *last,
+                                        [this](Value const& a, Value const& b) { return comp_(KeyOf()(a), KeyOf()(b)); });
+            if (last != pos && !comp_(KeyOf()(*last), KeyOf()(*pos)))
+            {
+               data_.pop_back();
+               return { pos, false };
+            }
+            std::rotate(pos, last, data_.end());
+            return { pos, true };
+         }
+
+      private:
+         container_t data_;
+         Compare comp_;
+      };
+   }
+
+   template<typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key>>
+   class flat_multiset : public detail::sorted_vector<Key, detail::key_is_value, Compare, Allocator>
+   {
+      using base_t = detail::sorted_vector<Key, detail::key_is_value, Compare, Allocator>;
+   public:
+      using key_type = Key;
+      using typename base_t::const_iterator;
+      using base_t::base_t;
+
+      const_iterator insert(Key key) { return this->emplace_equal(std::move(key)); }
+
+      template<typename... Args>
+      const_iterator emplace(Args&&... args) { return this->emplace_equal(std::forward<Args>(args)...); }
+
+      // adds an element at the end, without sorting it into place: call sort() before searching the container
+      template<typename... Args>
+      void append(Args&&... args) { this->emplace_back(std::forward<Args>(args)...); }
+   };
+
+   template<typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key>>
+   class flat_set : public detail::sorted_vector<Key, detail::key_is_value, Compare, Allocator>
+   {
+      using base_t = detail::sorted_vector<Key, detail::key_is_value, Compare, Allocator>;
+   public:
+      using key_type = Key;
+      using typename base_t::const_iterator;
+      using base_t::base_t;
+
+      std::pair<const_iterator, bool> insert(Key key) { return this->emplace_unique(std::move(key)); }
+
+      template<typename... Args>
+      std::pair<const_iterator, bool> emplace(Args&&... args) { return this->emplace_unique(std::forward<Args>(args)...); }
    };
-   using string_stream = stringstream_proxy;
+
+   template<typename Key, typename Value, typename Compare = std::less<Key>, typename Allocator = std::allocator<std::pair<Key, Value>>>
+   class flat_multimap : public detail::sorted_vector<std::pair<Key, Value>, detail::key_is_first, Compare, Allocator>
+   {
+      using base_t = detail::sorted_vector<std::pair<Key, Value>, detail::key_is_first, Compare, Allocator>;
+   public:
+      using key_type = Key;
+      using mapped_type = Value;
+      using value_type = std::pair<Key, Value>;
+      using typename base_t::const_iterator;
+      using base_t::base_t;
+
+      const_iterator insert(value_type value) { return this->emplace_equal(std::move(value)); }
+
+      template<typename... Args>
+      const_iterator emplace(Args&&... args) { return this->emplace_equal(std::forward<Args>(args)...); }
+
+      // adds an element at the end, without sorting it into place: call sort() before searching the container
+      template<typename... Args>
+      void append(Args&&... args) { this->emplace_back(std::forward<Args>(args)...); }
+   };
+
+   //////////////////////////////////////////////////////////////////////////
+   // Recycling: the elements of a container being cleared are kept as spares, and the next elements are assigned
+   // into them. Strings keep their capacity and tree nodes are reused (C++17 node handles), so re-parsing similar
+   // command lines does not allocate. Without node handles, node-based containers are simply cleared.
+
+   namespace detail
+   {
+      template<typename Char, typename Traits, typename Alloc, typename Slice>
+      void assign_slice(std::basic_string<Char, Traits, Alloc>& str, Slice const& slice)
+      {
+         str.assign(slice.data(), slice.size());
+      }
+
+#if defined(ARGH_HAS_STRING_VIEW)
+      template<typename Char, typename Traits>
+      void assign_slice(std::basic_string_view<Char, Traits>& str, std::basic_string_view<Char, Traits> slice)
+      {
+         str = slice;
+      }
+#endif
+
+      // the chars of an arg given as a string, or as a null-terminated string
+      template<typename Char>
+      Char const* arg_data(Char const* arg) { return arg; }
+
+      template<typename Char>
+      size_t arg_size(Char const* arg) { return std::char_traits<Char>::length(arg); }
+
+      template<typename S>
+      auto arg_data(S const& arg) -> decltype(arg.data()) { return arg.data(); }
+
+      template<typename S>
+      auto arg_size(S const& arg) -> decltype(arg.size()) { return arg.size(); }
+
+      template<typename Char, typename Traits, typename Alloc>
+      void assign_range(std::basic_string<Char, Traits, Alloc>& str, Char const* first, Char const* last)
+      {
+         str.assign(first, last);
+      }
+
+#if defined(ARGH_HAS_STRING_VIEW)
+      template<typename Char, typename Traits>
+      void assign_range(std::basic_string_view<Char, Traits>& str, Char const* first, Char const* last)
+      {
+         str = std::basic_string_view<Char, Traits>(first, static_cast<size_t>(last - first));
+      }
 #endif
 
-   class multimap_iteration_wrapper
+      template<typename String, typename Slice>
+      void assign_value(String& value, Slice const& slice)
+      {
+         assign_slice(value, slice);
+      }
+
+      template<typename Key, typename Value, typename KeySlice, typename ValueSlice>
+      void assign_value(std::pair<Key, Value>& value, KeySlice const& key, ValueSlice const& mapped)
+      {
+         assign_slice(value.first, key);
+         assign_slice(value.second, mapped);
+      }
+
+      // the spare elements kept for a container: node handles when available, otherwise values
+      template<typename Container, typename = void>
+      struct spare_of { using type = typename Container::value_type; };
+
+      // the spares are a cache of the parser that owns them: a copy starts without any, and keeps its own when assigned
+      template<typename Vector>
+      struct spare_list : Vector
+      {
+         using Vector::Vector;
+         spare_list() = default;
+         spare_list(spare_list const& other)
+            : Vector(std::allocator_traits<typename Vector::allocator_type>::select_on_container_copy_construction(other.get_allocator())) {}
+         spare_list(spare_list&&) = default;
+         spare_list& operator=(spare_list const&) { return *this; }
+         spare_list& operator=(spare_list&&) = default;
+      };
+
+      // remembers the object that set it: a copy or a move starts unmarked, so that it does not trust
+      // pointers into the containers of the original
+      struct owner_mark
+      {
+         void const* owner = nullptr;
+
+         owner_mark() = default;
+         owner_mark(owner_mark const&) {}
+         owner_mark& operator=(owner_mark const&) { owner = nullptr; return *this; }
+      };
+
+      template<typename T, typename Alloc, typename Spares>
+      void clear_into(std::vector<T, Alloc>& container, Spares& spares)
+      {
+         std::move(container.begin(), container.end(), std::back_inserter(spares));
+         container.clear();
+      }
+
+      template<typename Value, typename KeyOf, typename Compare, typename Alloc, typename Spares>
+      void clear_into(sorted_vector<Value, KeyOf, Compare, Alloc>& container, Spares& spares)
+      {
+         container.clear_into(spares);
+      }
+
+      template<typename T, typename Alloc, typename Spares, typename... Slices>
+      void emplace_recycled(std::vector<T, Alloc>& container, Spares& spares, Slices const&... slices)
+      {
+         if (spares.empty())
+            return (void)container.emplace_back(slices...);
+         container.push_back(std::move(spares.back()));
+         spares.pop_back();
+         assign_value(container.back(), slices...);
+      }
+
+      // flat containers are appended to, and sorted once all the elements are in, see sort_recycled()
+      template<typename Container, typename Spares, typename... Slices>
+      void emplace_recycled_flat(Container& container, Spares& spares, Slices const&... slices)
+      {
+         if (spares.empty())
+            return (void)container.append(slices...);
+         assign_value(spares.back(), slices...);
+         container.append(std::move(spares.back()));
+         spares.pop_back();
+      }
+
+      template<typename Key, typename Compare, typename Alloc, typename Spares, typename... Slices>
+      void emplace_recycled(flat_multiset<Key, Compare, Alloc>& container, Spares& spares, Slices const&... slices)
+      {
+         emplace_recycled_flat(container, spares, slices...);
+      }
+
+      template<typename Key, typename Value, typename Compare, typename Alloc, typename Spares, typename... Slices>
+      void emplace_recycled(flat_multimap<Key, Value, Compare, Alloc>& container, Spares& spares, Slices const&... slices)
+      {
+         emplace_recycled_flat(container, spares, slices...);
+      }
+
+      // makes the flat containers emplace_recycled() appended to searchable, the others always are
+      template<typename Container>
+      void sort_recycled(Container&) {}
+
+      template<typename Key, typename Compare, typename Alloc>
+      void sort_recycled(flat_multiset<Key, Compare, Alloc>& container) { container.sort(); }
+
+      template<typename Key, typename Value, typename Compare, typename Alloc>
+      void sort_recycled(flat_multimap<Key, Value, Compare, Alloc>& container) { container.sort(); }
+
+#if defined(ARGH_HAS_STRING_VIEW)
+      // wrapped, so that an allocator-aware vector of spares does not construct node handles with its allocator
+      template<typename Node>
+      struct spare_node { Node node; };
+
+      template<typename Container>
+      struct spare_of<Container, std::void_t<typename Container::node_type>> { using type = spare_node<typename Container::node_type>; };
+
+      template<typename Node, typename Slice>
+      auto assign_node(Node& node, Slice const& slice) -> decltype(node.value(), void())
+      {
+         assign_slice(node.value(), slice);
+      }
+
+      template<typename Node, typename KeySlice, typename ValueSlice>
+      auto assign_node(Node& node, KeySlice const& key, ValueSlice const& mapped) -> decltype(node.key(), void())
+      {
+         assign_slice(node.key(), key);
+         assign_slice(node.mapped(), mapped);
+      }
+
+      template<typename Container, typename Spares>
+      auto clear_into(Container& container, Spares& spares) -> decltype(container.extract(container.begin()), void())
+      {
+         while (!container.empty())
+            spares.push_back({ container.extract(container.begin()) });
+      }
+
+      template<typename Container, typename Spares, typename... Slices>
+      auto emplace_recycled(Container& container, Spares& spares, Slices const&... slices) -> decltype(container.extract(container.begin()), void())
+      {
+         if (spares.empty())
+            return (void)container.emplace(slices...);
+         assign_node(spares.back().node, slices...);
+         container.insert(std::move(spares.back().node));
+         spares.pop_back();
+      }
+#else
+      template<typename Container, typename Spares>
+      void clear_into(Container& container, Spares&)
+      {
+         container.clear();
+      }
+
+      template<typename Container, typename Spares, typename... Slices>
+      void emplace_recycled(Container& container, Spares&, Slices const&... slices)
+      {
+         container.emplace(slices...);
+      }
+#endif
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Shell-style splitting of a command line string, see parser::parse_string().
+
+   namespace detail
+   {
+      // chars that may end a run of plain token chars: whitespace (and other control chars), quotes and backslash
+      template<typename Char>
+      bool may_end_plain_run(Char c)
+      {
+         return static_cast<typename std::make_unsigned<Char>::type>(c) <= ' ' || '"' == c || '\'' == c || '\\' == c;
+      }
+
+      template<typename Char>
+      Char* plain_run_end(Char* first, Char* last)
+      {
+         while (first != last && !may_end_plain_run(*first))
+            ++first;
+         return first;
+      }
+
+      // non-zero if a byte of x is less than n (n <= 128)
+      inline std::uint64_t swar_has_less(std::uint64_t x, unsigned char n)
+      {
+         return (x - 0x0101010101010101ull * n) & ~x & 0x8080808080808080ull;
+      }
+
+      // non-zero if a byte of x is c
+      inline std::uint64_t swar_has_byte(std::uint64_t x, unsigned char c)
+      {
+         return swar_has_less(x ^ (0x0101010101010101ull * c), 1);
+      }
+
+      // narrow chars are scanned 8 at a time: blocks without any special byte are skipped whole
+      inline char* plain_run_end(char* first, char* last)
+      {
+         for (; last - first >= 8; first += 8)
+         {
+            std::uint64_t block;
+            std::memcpy(&block, first, sizeof(block));
+            if (swar_has_less(block, ' ' + 1) | swar_has_byte(block, '"') | swar_has_byte(block, '\'') | swar_has_byte(block, '\\'))
+               break;
+         }
+         return plain_run_end<char>(first, last);
+      }
+
+      // the first c in [first, last), or last. Used to split list values, see parser::get_list().
+      template<typename Char>
+      Char const* find_char(Char const* first, Char const* last, Char c)
+      {
+         return std::find(first, last, c);
+      }
+
+      // narrow chars are scanned 8 at a time, like above
+      inline char const* find_char(char const* first, char const* last, char c)
+      {
+         for (; last - first >= 8; first += 8)
+         {
+            std::uint64_t block;
+            std::memcpy(&block, first, sizeof(block));
+            if (swar_has_byte(block, static_cast<unsigned char>(c)))
+               break;
+         }
+         return std::find(first, last, c);
+      }
+
+      template<typename Char>
+      bool is_shell_space(Char c)
+      {
+         return ' ' == c || ('\t' <= c && c <= '\r');
+      }
+
+      // Splits [first, last) in place, like a POSIX shell: on unquoted whitespace, with '...' quoting literally,
+      // "..." quoting with the \" \\ \$ \` and \<newline> escapes, and \ escaping any char outside of quotes.
+      // Quotes and escapes are removed, and adjacent quoted and unquoted parts make a single token.
+      // Tokens are compacted towards first, on_token(token_first, token_last) is called for each of them.
+      // Returns false if the string ends inside quotes, which are then closed at the end.
+      template<typename Char, typename OnToken>
+      bool split_command_line(Char* first, Char* last, OnToken&& on_token)
+      {
+         auto read = first;
+         auto write = first;
+         for (;;)
+         {
+            while (read != last && (is_shell_space(*read) || ('\\' == *read && 1 < last - read && '\n' == read[1])))
+               read += is_shell_space(*read) ? 1 : 2;
+            if (read == last)
+               return true;
+
+            auto const token = write;
+            for (;;)
+            {
+               auto const plain_end = plain_run_end(read, last);
+               write = write == read ? plain_end : std::copy(read, plain_end, write);
+               read = plain_end;
+               if (read == last || is_shell_space(*read))
+                  break;
+
+               auto const c = *read++;
+               if ('\'' == c)
+               {
+                  auto const close = std::find(read, last, Char('\''));
+                  write = std::copy(read, close, write);
+                  if (close == last)
+                  {
+                     on_token(token, write);
+                     return false;
+                  }
+                  read = close + 1;
+               }
+               else if ('"' == c)
+               {
+                  for (;;)
+                  {
+                     auto stop = read;
+                     while (stop != last && '"' != *stop && '\\' != *stop)
+                        ++stop;
+                     write = std::copy(read, stop, write);
+                     read = stop;
+                     if (read == last)
+                     {
+                        on_token(token, write);
+                        return false;
+                     }
+                     if ('"' == *read++)
+                        break;
+                     if (read != last && '\n' == *read)
+                        ++read;
+                     else if (read != last && ('"' == *read || '\\' == *read || '$' == *read || '`' == *read))
+                        *write++ = *read++;
+                     else
+                        *write++ = '\\';
+                  }
+               }
+               else if ('\\' == c)
+               {
+                  if (read == last)
+                     *write++ = '\\';
+                  else if ('\n' == *read)
+                     ++read;
+                  else
+                     *write++ = *read++;
+               }
+               else // a control char that is not whitespace
+               {
+                  *write++ = c;
+               }
+            }
+            on_token(token, write);
+         }
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Response files, see parser_base::EXPAND_RESPONSE_FILES.
+
+   namespace detail
+   {
+      // The contents of a response file: memory-mapped copy-on-write, so that it can be split in place
+      // and only the pages actually unquoted get copied, or read into memory when it cannot be mapped
+      // (pipes, special files, systems without mmap).
+      class response_file
+      {
+      public:
+         // identifies a file, to detect response files including themselves
+         using id_type = std::pair<unsigned long long, unsigned long long>;
+
+         explicit response_file(char const* path);
+         response_file(response_file&& other) noexcept;
+         response_file& operator=(response_file&& other) noexcept;
+         ~response_file();
+
+         explicit operator bool() const { return ok_;            }
+         id_type id()             const { return id_;            }
+         char* begin()                  { return data_;          }
+         char* end()                    { return data_ + size_;  }
+
+      private:
+         void release();
+
+         char* data_ = nullptr;
+         size_t size_ = 0;
+         bool mapped_ = false;
+         bool ok_ = false;
+         id_type id_;
+         std::vector<char> buffer_;
+      };
+
+      //////////////////////////////////////////////////////////////////////////
+
+      inline response_file::response_file(char const* path)
+      {
+#if defined(ARGH_HAS_MMAP)
+         int fd = ::open(path, O_RDONLY);
+         if (fd < 0)
+            return;
+
+         struct stat st;
+         if (0 != ::fstat(fd, &st))
+         {
+            ::close(fd);
+            return;
+         }
+         id_ = id_type(static_cast<unsigned long long>(st.st_dev), static_cast<unsigned long long>(st.st_ino));
+
+         if (S_ISREG(st.st_mode) && 0 < st.st_size)
+         {
+            auto const size = static_cast<size_t>(st.st_size);
+            void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED != mapping)
+            {
+               ::close(fd);
+               data_ = static_cast<char*>(mapping);
+               size_ = size;
+               mapped_ = true;
+               ok_ = true;
+               return;
+            }
+         }
+
+         char chunk[4096];
+         for (;;)
+         {
+            auto const got = ::read(fd, chunk, sizeof(chunk));
+            if (0 < got)
+               buffer_.insert(buffer_.end(), chunk, chunk + got);
+            else if (0 == got)
+               break;
+            else if (EINTR != errno)
+            {
+               ::close(fd);
+               return;
+            }
+         }
+         ::close(fd);
+#else
+         std::FILE* file = std::fopen(path, "rb");
+         if (!file)
+            return;
+         id_ = id_type(0, std::hash<std::string>()(path));
+
+         char chunk[4096];
+         size_t got;
+         while (0 < (got = std::fread(chunk, 1, sizeof(chunk), file)))
+            buffer_.insert(buffer_.end(), chunk, chunk + got);
+         bool const failed = 0 != std::ferror(file);
+         std::fclose(file);
+         if (failed)
+            return;
+#endif
+         data_ = buffer_.data();
+         size_ = buffer_.size();
+         ok_ = true;
+      }
+
+      //////////////////////////////////////////////////////////////////////////
+
+      inline response_file::response_file(response_file&& other) noexcept
+      {
+         *this = std::move(other);
+      }
+
+      //////////////////////////////////////////////////////////////////////////
+
+      inline response_file& response_file::operator=(response_file&& other) noexcept
+      {
+         if (this != &other)
+         {
+            release();
+            // a moved vector keeps its elements where they are, so data_ stays valid
+            buffer_ = std::move(other.buffer_);
+            data_ = other.data_;
+            size_ = other.size_;
+            mapped_ = other.mapped_;
+            ok_ = other.ok_;
+            id_ = other.id_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+            other.mapped_ = false;
+            other.ok_ = false;
+         }
+         return *this;
+      }
+
+      //////////////////////////////////////////////////////////////////////////
+
+      inline response_file::~response_file()
+      {
+         release();
+      }
+
+      //////////////////////////////////////////////////////////////////////////
+
+      inline void response_file::release()
+      {
+#if defined(ARGH_HAS_MMAP)
+         if (mapped_)
+            ::munmap(data_, size_);
+#endif
+         mapped_ = false;
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Single-byte flags, see basic_parser::byte_flags_.
+
+   namespace detail
+   {
+      // the 256 byte values as chars, for the single-byte names a view_parser refers to
+      template<typename Char>
+      Char const* byte_chars()
+      {
+         static struct table
+         {
+            Char chars[256];
+            table() { for (int c = 0; c < 256; ++c) chars[c] = static_cast<Char>(c); }
+         } const bytes;
+         return bytes.chars;
+      }
+
+      // the byte value of a one-char name, or -1
+      template<typename S>
+      int byte_name(S const& name)
+      {
+         using unsigned_char = typename std::make_unsigned<typename S::value_type>::type;
+         if (1 != name.size() || 256 <= static_cast<unsigned_char>(name[0]))
+            return -1;
+         return static_cast<int>(static_cast<unsigned_char>(name[0]));
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Fingerprints, see parser::fingerprint().
+
+   namespace detail
+   {
+#if defined(__SIZEOF_INT128__)
+      __extension__ typedef unsigned __int128 uint128;
+#endif
+
+      // the 128-bit product of a and b, folded to 64 bits
+      inline uint64_t mix_mul(uint64_t a, uint64_t b)
+      {
+#if defined(__SIZEOF_INT128__)
+         auto const product = static_cast<uint128>(a) * b;
+         return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+         uint64_t const lo_lo = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF);
+         uint64_t const hi_lo = (a >> 32) * (b & 0xFFFFFFFF);
+         uint64_t const lo_hi = (a & 0xFFFFFFFF) * (b >> 32);
+         uint64_t const hi_hi = (a >> 32) * (b >> 32);
+         uint64_t const cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+         return ((cross << 32) | (lo_lo & 0xFFFFFFFF)) ^ (hi_hi + (hi_lo >> 32) + (cross >> 32));
+#endif
+      }
+
+      // up to 8 bytes, little-endian whatever the machine
+      inline uint64_t read_le(unsigned char const* bytes, size_t size)
+      {
+         uint64_t value = 0;
+         for (size_t i = 0; i < size; ++i)
+            value |= uint64_t(bytes[i]) << (8 * i);
+         return value;
+      }
+
+      // a wyhash-like 64-bit hash of size bytes: 16 bytes a step, mixed by 128-bit multiplications
+      inline uint64_t hash_bytes(void const* data, size_t size, uint64_t seed)
+      {
+         uint64_t const k0 = 0xa0761d6478bd642fULL, k1 = 0xe7037ed1a0b428dbULL, k2 = 0x8ebc6af09c88c6e3ULL;
+         auto bytes = static_cast<unsigned char const*>(data);
+         auto const total = static_cast<uint64_t>(size);
+         auto h = mix_mul(seed ^ k0, total ^ k1);
+         for (; 16 < size; bytes += 16, size -= 16)
+            h = mix_mul(read_le(bytes, 8) ^ k1, read_le(bytes + 8, 8) ^ h);
+         auto const a = read_le(bytes, size < 8 ? size : 8);
+         auto const b = 8 < size ? read_le(bytes + 8, size - 8) : 0;
+         return mix_mul(mix_mul(a ^ k1, b ^ h) ^ k2, total ^ k0);
+      }
+
+      template<typename S>
+      uint64_t hash_string(S const& s, uint64_t seed)
+      {
+         return hash_bytes(s.data(), s.size() * sizeof(typename S::value_type), seed);
+      }
+
+      // seeds keeping the kinds of args apart
+      enum : uint64_t { flag_seed = 1, param_seed = 2, pos_arg_seed = 3, remainder_seed = 4, fallback_seed = 5 };
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Parser snapshots, see parser::serialize() and argh::frozen_parser.
+
+   namespace detail
+   {
+      // A snapshot is a header, a table of string refs, then the strings. The header and the table are 32-bit words
+      // in the writer's byte order; a ref is the offset of a string in the strings, and its size. The table holds
+      // the flags, sorted, then the params sorted by name as name and value refs (the values of a repeated param
+      // in order), the positional args, the remainder, then the fallback values sorted by name, as name and value refs.
+      struct frozen_format
+      {
+         enum : uint32_t { magic = 0x48475241 /* "ARGH" */, version = 1 };
+         enum header_word : size_t { magic_word, version_word, flag_count, param_count, pos_arg_count, remainder_count, fallback_count, strings_size, header_words };
+
+         static uint32_t word(char const* words, size_t i)
+         {
+            uint32_t w;
+            std::memcpy(&w, words + i * sizeof(uint32_t), sizeof(uint32_t));
+            return w;
+         }
+      };
+
+      // builds a snapshot: add the refs of the table in order, then take the blob
+      class frozen_writer
+      {
+      public:
+         frozen_writer() : words_(frozen_format::header_words, 0) {}
+
+         void set_count(frozen_format::header_word which, size_t count) { words_[which] = checked(count); }
+
+         // repeated names are usually consecutive, sorted: these share the string of the previous one
+         void add_name(char const* data, size_t size)
+         {
+            if (size != last_name_size_ || 0 != std::memcmp(strings_.data() + last_name_, data, size))
+            {
+               last_name_ = strings_.size();
+               last_name_size_ = size;
+               strings_.append(data, size);
+            }
+            words_.push_back(checked(last_name_));
+            words_.push_back(checked(size));
+         }
+
+         void add(char const* data, size_t size)
+         {
+            words_.push_back(checked(strings_.size()));
+            words_.push_back(checked(size));
+            strings_.append(data, size);
+         }
+
+         std::string blob()
+         {
+            words_[frozen_format::magic_word] = frozen_format::magic;
+            words_[frozen_format::version_word] = frozen_format::version;
+            words_[frozen_format::strings_size] = checked(strings_.size());
+
+            std::string blob(words_.size() * sizeof(uint32_t) + strings_.size(), '\0');
+            std::memcpy(&blob[0], words_.data(), words_.size() * sizeof(uint32_t));
+            std::memcpy(&blob[words_.size() * sizeof(uint32_t)], strings_.data(), strings_.size());
+            return blob;
+         }
+
+         // the offsets, sizes and counts of a snapshot are 32-bit: a larger parse cannot be serialized
+         static uint32_t checked(size_t value)
+         {
+            if (UINT32_MAX < value)
+               throw std::length_error("argh: the parse is too large for a snapshot");
+            return static_cast<uint32_t>(value);
+         }
+
+      private:
+         std::vector<uint32_t> words_;
+         std::string strings_;
+         size_t last_name_ = 0;
+         size_t last_name_size_ = size_t(-1);
+      };
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Storage policies: the containers basic_parser keeps args, flags, params and registered param names in,
+   // and the allocator they are all constructed with.
+
+   // Node-based std:: containers, the default.
+   struct node_storage
+   {
+      using allocator_type = std::allocator<char>;
+
+      template<typename T>
+      using vector = std::vector<T>;
+      template<typename Key>
+      using multiset = std::multiset<Key>;
+      template<typename Key, typename Value>
+      using multimap = std::multimap<Key, Value>;
+      template<typename Key, typename Compare>
+      using set = std::set<Key, Compare>;
+   };
+
+   // Sorted vectors. Usually faster for the few dozen options of typical command lines. The flags and params
+   // of a parse are appended as they are found, then sorted once at its end.
+   struct flat_storage
+   {
+      using allocator_type = std::allocator<char>;
+
+      template<typename T>
+      using vector = std::vector<T>;
+      template<typename Key>
+      using multiset = flat_multiset<Key>;
+      template<typename Key, typename Value>
+      using multimap = flat_multimap<Key, Value>;
+      template<typename Key, typename Compare>
+      using set = flat_set<Key, Compare>;
+   };
+
+   // Any of the above, with the parsed args copied once into one buffer sized from their total length, instead of
+   // being referred to (by a std::string_view parser) or copied one std::string at a time: see argh::pooled_parser.
+   template<typename Base>
+   struct pooled_storage : Base
+   {
+      static constexpr bool pool_args = true;
+   };
+
+   namespace detail
+   {
+      template<typename Storage, typename = void>
+      struct pools_args : std::false_type {};
+
+      template<typename Storage>
+      struct pools_args<Storage, decltype(void(Storage::pool_args))> : std::integral_constant<bool, Storage::pool_args> {};
+
+      // a base making a parser move-only, when its views into its own buffer would go stale in a copy
+      template<bool MoveOnly>
+      struct copy_policy {};
+
+      template<>
+      struct copy_policy<true>
+      {
+         copy_policy() = default;
+         copy_policy(copy_policy const&) = delete;
+         copy_policy(copy_policy&&) = default;
+         copy_policy& operator=(copy_policy const&) = delete;
+         copy_policy& operator=(copy_policy&&) = default;
+      };
+   }
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+   // Same as above, with every container and (std::pmr::) string allocated from a std::pmr::memory_resource,
+   // e.g. a std::pmr::monotonic_buffer_resource over a stack buffer. The resource must outlive the parser.
+   struct pmr_storage
+   {
+      using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+      template<typename T>
+      using vector = std::pmr::vector<T>;
+      template<typename Key>
+      using multiset = std::pmr::multiset<Key>;
+      template<typename Key, typename Value>
+      using multimap = std::pmr::multimap<Key, Value>;
+      template<typename Key, typename Compare>
+      using set = std::pmr::set<Key, Compare>;
+   };
+
+   struct pmr_flat_storage
+   {
+      using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+      template<typename T>
+      using vector = std::pmr::vector<T>;
+      template<typename Key>
+      using multiset = flat_multiset<Key, std::less<Key>, std::pmr::polymorphic_allocator<Key>>;
+      template<typename Key, typename Value>
+      using multimap = flat_multimap<Key, Value, std::less<Key>, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+      template<typename Key, typename Compare>
+      using set = flat_set<Key, Compare, std::pmr::polymorphic_allocator<Key>>;
+   };
+
+   // Counts the allocations made from it, e.g. by a pmr_parser, and passes each allocation and deallocation
+   // to the optional trace callback. Allocates from upstream. Not thread-safe, like std::pmr::monotonic_buffer_resource.
+   class counting_resource : public std::pmr::memory_resource
+   {
+   public:
+      using trace_callback = void (*)(void* context, void* p, size_t bytes, bool allocated);
+
+      explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource(), trace_callback trace = nullptr, void* context = nullptr)
+         : upstream_(upstream)
+         , trace_(trace)
+         , context_(context)
+      {}
+
+      size_t allocations()   const { return allocations_;   }
+      size_t deallocations() const { return deallocations_; }
+      size_t bytes_in_use()  const { return bytes_in_use_;  }
+      size_t peak_bytes()    const { return peak_bytes_;    }
+
+   private:
+      void* do_allocate(size_t bytes, size_t alignment) override
+      {
+         auto const p = upstream_->allocate(bytes, alignment);
+         ++allocations_;
+         bytes_in_use_ += bytes;
+         peak_bytes_ = std::max(peak_bytes_, bytes_in_use_);
+         if (trace_)
+            trace_(context_, p, bytes, true);
+         return p;
+      }
+
+      void do_deallocate(void* p, size_t bytes, size_t alignment) override
+      {
+         if (trace_)
+            trace_(context_, p, bytes, false);
+         ++deallocations_;
+         bytes_in_use_ -= bytes;
+         upstream_->deallocate(p, bytes, alignment);
+      }
+
+      bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override { return this == &other; }
+
+      std::pmr::memory_resource* upstream_;
+      trace_callback trace_;
+      void* context_;
+      size_t allocations_ = 0;
+      size_t deallocations_ = 0;
+      size_t bytes_in_use_ = 0;
+      size_t peak_bytes_ = 0;
+   };
+#endif
+
+   // Parsing modes, shared by all parser variants.
+   class parser_base
+   {
+   public:
+      enum Mode { PREFER_FLAG_FOR_UNREG_OPTION = 1 << 0,
+                  PREFER_PARAM_FOR_UNREG_OPTION = 1 << 1,
+                  NO_SPLIT_ON_EQUALSIGN = 1 << 2,
+                  SINGLE_DASH_IS_MULTIFLAG = 1 << 3,
+                  EXPAND_RESPONSE_FILES = 1 << 4,
+                  DOUBLE_DASH_ENDS_OPTIONS = 1 << 5,
+                  MATCH_UNIQUE_PREFIX = 1 << 6,
+                };
+   };
+
+   // Handle to a name registered with add_param() or add_flag(). The name is looked up once per parse,
+   // so that accessing the parser by key is an index into the results instead of a search for the name.
+   // A key is only meaningful to the parser that returned it, and a default constructed key is never found.
+   class key
+   {
+   public:
+      key() = default;
+      explicit operator bool() const { return size_t(-1) != index_; }
+
+   private:
+      template<typename, typename> friend class basic_parser;
+      explicit key(size_t index) : index_(index) {}
+      size_t index_ = size_t(-1);
+   };
+
+   namespace detail
+   {
+      enum class arg_kind { positional, negative_number, option, option_with_value };
+
+      inline bool is_option(arg_kind kind) { return arg_kind::option == kind || arg_kind::option_with_value == kind; }
+
+      template<typename S>
+      S trim_leading_dashes(S const& name)
+      {
+         auto pos = name.find_first_not_of('-');
+         return S::npos != pos ? name.substr(pos) : name;
+      }
+
+      template<typename S>
+      arg_kind classify(S const& arg, int mode)
+      {
+         if (arg.empty() || '-' != arg[0])
+            return arg_kind::positional;
+
+         if (starts_with_number(arg.data(), arg.data() + arg.size()))
+            return arg_kind::negative_number;
+
+         if (!(mode & parser_base::NO_SPLIT_ON_EQUALSIGN) && S::npos != arg.find('=', arg.find_first_not_of('-')))
+            return arg_kind::option_with_value;
+
+         return arg_kind::option;
+      }
+
+#if defined(ARGH_ENABLE_STATS)
+      // tells the sink how an arg was classified, if it wants to know
+      template<typename Sink, typename Arg>
+      auto note_classified(Sink& sink, Arg const& arg, arg_kind kind, int) -> decltype(sink.classified(arg, kind), void())
+      {
+         sink.classified(arg, kind);
+      }
+
+      template<typename Sink, typename Arg>
+      void note_classified(Sink&, Arg const&, arg_kind, long) {}
+#endif
+
+      // The parse loop shared by the parsers, fed one arg at a time: splits the args into flags, params and positional
+      // args and hands them to the sink, which decides how to store them:
+      //    bool is_param(Slice const& name)              is name a registered param?
+      //    bool is_flag(Slice const& name)               is name a registered flag? never takes a value
+      //    bool is_subcommand(arg)                       does a positional arg (but the first) end the parsing?
+      //    void flag(Slice const& name)
+      //    void param(Slice const& name, value)          value is a Slice or one of the args
+      //    void positional(arg)                          arg is one of the args
+      // An arg is only handled once the next one is known, or at finish(), since an option takes the next arg as its
+      // value unless that is an option too: each pushed arg must stay valid until the next push() or finish().
+      template<typename Slice, typename Arg, typename Sink>
+      class arg_scanner
+      {
+      public:
+         arg_scanner(int mode, Sink& sink) : mode_(mode), sink_(sink) {}
+
+         // returns false once the parsing stopped: arg and the args pushed after it are then left unparsed
+         bool push(Arg const& arg)
+         {
+            if (stopped_)
+               return false;
+
+            // each arg is classified exactly once, as the lookahead of the one before it
+            auto const kind = classify(arg, mode_);
+            ARGH_STATS(note_classified(sink_, arg, kind, 0);)
+            if (pending_ && handle(&arg, kind))
+               pending_ = nullptr; // the value of the pending option
+            else if (!stopped_)
+               pending_ = &arg, pending_kind_ = kind;
+            ++count_;
+            return !stopped_;
+         }
+
+         // handles the last arg, returns remainder_first()
+         size_t finish()
+         {
+            if (pending_ && !stopped_)
+               handle(nullptr, arg_kind::positional);
+            pending_ = nullptr;
+            return remainder_first();
+         }
+
+         // the number of args pushed, and where the remainder, the args left unparsed, starts among them: at the
+         // subcommand that stopped the parsing, after the "--" that did, else after the last arg
+         size_t size() const            { return count_; }
+         bool stopped() const           { return stopped_; }
+         size_t remainder_first() const { return stopped_ ? remainder_first_ : count_; }
+
+      private:
+         void stop(size_t remainder_first)
+         {
+            stopped_ = true;
+            remainder_first_ = remainder_first;
+         }
+
+         // handles the pending arg, returns true if it took next as its value
+         bool handle(Arg const* next, arg_kind next_kind)
+         {
+            auto const& arg = *pending_;
+            auto const i = count_ - 1;
+
+            if (!is_option(pending_kind_))
+            {
+               if (0 < i && sink_.is_subcommand(arg))
+               {
+                  stop(i);
+                  return false;
+               }
+               sink_.positional(arg);
+               return false;
+            }
+
+            if (parser_base::DOUBLE_DASH_ENDS_OPTIONS & mode_ && 2 == arg.size() && '-' == arg[1])
+            {
+               stop(i + 1);
+               return false;
+            }
+
+            auto name = trim_leading_dashes(Slice(arg));
+
+            if (arg_kind::option_with_value == pending_kind_)
+            {
+               auto equalPos = name.find('=');
+               sink_.param(name.substr(0, equalPos), name.substr(equalPos + 1));
+               return false;
+            }
+
+            // if the option is unregistered and should be a multi-flag
+            if (1 == (arg.size() - name.size()) &&                // single dash
+               parser_base::SINGLE_DASH_IS_MULTIFLAG & mode_ &&   // multi-flag mode
+               !sink_.is_param(name))                             // unregistered
+            {
+               Slice keep_param;
+
+               if (!name.empty() && sink_.is_param(name.substr(name.size() - 1))) // last char is param
+               {
+                  keep_param = name.substr(name.size() - 1);
+                  name = name.substr(0, name.size() - 1);
+               }
+
+               for (auto c = 0u; c < name.size(); ++c)
+               {
+                  sink_.flag(name.substr(c, 1));
+               }
+
+               if (!keep_param.empty())
+               {
+                  name = keep_param;
+               }
+               else
+               {
+                  return false; // do not consider other options for this arg
+               }
+            }
+
+            // any potential option will get as its value the next arg, unless that arg is an option too
+            // in that case it will be determined a flag.
+            if (!next || is_option(next_kind))
+            {
+               sink_.flag(name);
+               return false;
+            }
+
+            // if 'name' is a pre-registered option, then the next arg cannot be a free parameter to it is skipped
+            // otherwise we have 2 modes:
+            // PREFER_FLAG_FOR_UNREG_OPTION: a non-registered 'name' is determined a flag.
+            //                               The following value (the next arg) will be a free parameter.
+            //
+            // PREFER_PARAM_FOR_UNREG_OPTION: a non-registered 'name' is determined a parameter, the next arg
+            //                                will be the value of that option.
+
+            assert(!(mode_ & parser_base::PREFER_FLAG_FOR_UNREG_OPTION)
+                || !(mode_ & parser_base::PREFER_PARAM_FOR_UNREG_OPTION));
+
+            bool preferParam = mode_ & parser_base::PREFER_PARAM_FOR_UNREG_OPTION;
+
+            if (sink_.is_param(name) || (preferParam && !sink_.is_flag(name)))
+            {
+               sink_.param(name, *next);
+               return true; // the next arg is not a free parameter
+            }
+
+            sink_.flag(name);
+            return false;
+         }
+
+         int mode_;
+         Sink& sink_;
+         Arg const* pending_ = nullptr;
+         arg_kind pending_kind_ = arg_kind::positional;
+         size_t count_ = 0;
+         size_t remainder_first_ = 0;
+         bool stopped_ = false;
+      };
+
+      // Runs the first count args through an arg_scanner, returns where the remainder starts
+      template<typename Slice, typename Args, typename Sink>
+      size_t scan_args(Args const& args, size_t count, int mode, Sink& sink)
+      {
+         arg_scanner<Slice, typename Args::value_type, Sink> scanner(mode, sink);
+         for (size_t i = 0; i < count && scanner.push(args[i]); ++i)
+            ;
+         return scanner.finish();
+      }
+   }
+
+#if defined(ARGH_ENABLE_STATS)
+   // What a parser did, see parser::stats(). Only defined with ARGH_ENABLE_STATS.
+   struct parse_stats
+   {
+      // the args classified by the last parse, by kind
+      size_t positional_args = 0;
+      size_t negative_numbers = 0;
+      size_t options = 0;
+      size_t options_with_value = 0; // --name=value
+      size_t number_checks = 0;      // the args starting with '-', checked for being a negative number
+
+      // the accessor lookups by name or key since the last parse, and those that found nothing
+      size_t lookups = 0;
+      size_t lookup_misses = 0;
+
+      // the heap bytes held by the containers, approximately: their buffers or nodes, and the strings they own
+      size_t args_bytes = 0;
+      size_t pos_args_bytes = 0;
+      size_t flags_bytes = 0;
+      size_t params_bytes = 0;
+   };
+
+   namespace detail
+   {
+      template<typename Char, typename Traits, typename Alloc>
+      size_t heap_bytes(std::basic_string<Char, Traits, Alloc> const& str)
+      {
+         // the capacity of an empty string is its small buffer, inside the string
+         static size_t const small_capacity = std::basic_string<Char, Traits, Alloc>().capacity();
+         return small_capacity < str.capacity() ? (str.capacity() + 1) * sizeof(Char) : 0;
+      }
+
+#if defined(ARGH_HAS_STRING_VIEW)
+      template<typename Char, typename Traits>
+      size_t heap_bytes(std::basic_string_view<Char, Traits> const&) { return 0; }
+#endif
+
+      template<typename First, typename Second>
+      size_t heap_bytes(std::pair<First, Second> const& value) { return heap_bytes(value.first) + heap_bytes(value.second); }
+
+      template<typename Container>
+      size_t element_heap_bytes(Container const& container)
+      {
+         size_t bytes = 0;
+         for (auto const& value : container)
+            bytes += heap_bytes(value);
+         return bytes;
+      }
+
+      // vectors, flat containers: their buffer
+      template<typename Container>
+      auto retained_bytes(Container const& container, int) -> decltype(container.capacity(), size_t())
+      {
+         return container.capacity() * sizeof(typename Container::value_type) + element_heap_bytes(container);
+      }
+
+      // node containers: a node per element, the value next to three pointers and a color
+      template<typename Container>
+      size_t retained_bytes(Container const& container, long)
+      {
+         return container.size() * (sizeof(typename Container::value_type) + 4 * sizeof(void*)) + element_heap_bytes(container);
+      }
+   }
+#endif
+
+   // String is the type used to store the parsed args:
+   // - std::string copies every arg (see argh::parser)
+   // - std::string_view refers back into the caller's argv, which must outlive the parser (see argh::view_parser),
+   //   or into a copy of it the parser owns with pooled_storage (see argh::pooled_parser)
+   // Storage is the policy selecting the containers, see node_storage and flat_storage.
+   template<typename String, typename Storage>
+   class basic_parser : public parser_base, private detail::copy_policy<detail::pools_args<Storage>::value>
+   {
+   public:
+      using string_type = String;
+      using char_type = typename String::value_type;
+      using traits_type = typename String::traits_type;
+      using stream_type = basic_string_stream<char_type, traits_type>;
+      using owned_string = typename detail::owning_string<String>::type;
+      using flags_container = typename Storage::template multiset<string_type>;
+      using params_container = typename Storage::template multimap<string_type, string_type>;
+      using pos_args_container = typename Storage::template vector<string_type>;
+      using params_range = basic_multimap_iteration_wrapper<params_container>;
+      using args_range = basic_multimap_iteration_wrapper<pos_args_container>;
+      using allocator_type = typename Storage::allocator_type;
+
+      // a one-char flag of the last parse, and how many times it was given, see byte_flags()
+      struct byte_flag
+      {
+         char_type const* name; // its char: the first one in the args for a view_parser
+         uint32_t count;
+      };
+      using byte_flags_container = typename Storage::template vector<byte_flag>;
+#if defined(ARGH_HAS_STRING_VIEW)
+      // args are split without copying, the parts are only copied when stored
+      using slice_type = std::basic_string_view<typename String::value_type, typename String::traits_type>;
+#else
+      using slice_type = owned_string;
+#endif
+
+      basic_parser() = default;
+
+      // all containers, and the strings they own, are allocated with alloc
+      explicit basic_parser(allocator_type const& alloc)
+         : args_(alloc)
+         , line_(alloc)
+         , params_(alloc)
+         , pos_args_(alloc)
+         , flags_(alloc)
+         , registeredParams_(alloc)
+         , registeredSubcommands_(alloc)
+         , registeredFlags_(alloc)
+         , names_by_key_(alloc)
+         , sorted_keys_(alloc)
+         , key_states_(alloc)
+         , alias_names_(alloc)
+         , alias_canonicals_(alloc)
+         , env_prefix_(alloc)
+         , env_bounds_(alloc)
+         , fallback_(alloc)
+         , merged_fallback_(alloc)
+         , sources_(alloc)
+         , source_entries_(alloc)
+         , byte_flag_list_(alloc)
+         , fingerprint_exclusions_(alloc)
+         , spare_params_(alloc)
+         , spare_pos_args_(alloc)
+         , spare_flags_(alloc)
+         , response_files_(alloc)
+         , expanded_args_(alloc)
+      {}
+
+      basic_parser(std::initializer_list<char_type const* const> pre_reg_names)
+      {  add_params(pre_reg_names); }
+
+      basic_parser(std::initializer_list<char_type const* const> pre_reg_names, allocator_type const& alloc)
+         : basic_parser(alloc)
+      {  add_params(pre_reg_names); }
+
+      basic_parser(const char_type* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION)
+      {  parse(argv, mode); }
+
+      basic_parser(int argc, const char_type* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION)
+      {  parse(argc, argv, mode); }
+
+      // register a param name, whose next arg is then always its value, and return its key. A key is looked up at
+      // its first access after a parse, further accesses by it are an index.
+      key add_param(slice_type const& name);
+      key add_params(slice_type const& name);
+
+      // register a flag name, that never takes the next arg as its value, and return its key
+      key add_flag(slice_type const& name);
+
+      void add_param(std::initializer_list<char_type const* const> init_list);
+      void add_params(std::initializer_list<char_type const* const> init_list);
+
+      // register alias groups: every alias is stored as canonical when parsed, and looked up as canonical,
+      // so that one probe finds a param or flag whatever spelling was used, and params(alias) yields them all.
+      // Returns the key of canonical. A view_parser refers to canonical, which must outlive it like argv.
+      key add_params(std::initializer_list<char_type const* const> aliases, slice_type const& canonical);
+      key add_flags(std::initializer_list<char_type const* const> aliases, slice_type const& canonical);
+
+      // the registered param and flag names starting with prefix, sorted: what an abbreviation could stand for
+      // in MATCH_UNIQUE_PREFIX mode. More than one (that are not aliases of one name) make it ambiguous.
+      std::vector<owned_string> candidates(slice_type const& prefix) const;
+
+      // params missing from the command line fall back to the environment: with the prefix "APP_", a registered
+      // param "max-jobs" falls back to APP_MAX_JOBS. The environment is read once per parse, and kept until the next one.
+      // Only parsers of char read the environment.
+      void set_env_prefix(slice_type const& prefix);
+
+      // layers a file of key=value lines under the command line and the environment, a later source over the
+      // earlier ones. The file is mapped, and split into views at the next parse. Returns false if it cannot be
+      // read. Only parsers of char read sources.
+      bool add_source(char const* path) { return add_source(path, std::is_same<char_type, char>()); }
+
+      // registers subcommand names: parsing stops at the first positional arg (not counting the first arg,
+      // the program's name) that is one of them. That arg and the ones after it are left in remainder().
+      void add_subcommand(slice_type const& name);
+      void add_subcommands(std::initializer_list<char_type const* const> init_list);
+
+      void parse(const char_type* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+      void parse(int argc, const char_type* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+
+      // splits line the way a POSIX shell would (on whitespace, with '...', "..." and \ escapes) into the parser's
+      // own storage, then parses the parts like argv. The first part is positional arg 0, like argv[0] would be.
+      // A view_parser refers into a copy of line it keeps until the next parse, and must not be copied meanwhile.
+      // Returns false if line ends inside quotes, which are then closed at the end.
+      bool parse_string(slice_type const& line, int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+
+      // parses a range of args, strings or null-terminated char_type pointers, e.g. the remainder() of another parser.
+      // A view_parser then refers into the strings of the range, without copying them.
+      template<typename It>
+      void parse(It first, It last, int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+
+      // same as parse(), but the storage of the previous parse (strings, nodes, buffers) is kept and reused.
+      // Re-parsing similarly shaped command lines this way does not allocate.
+      // Memory is only released by the next parse() or by the parser's destruction.
+      void reparse(const char_type* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+      void reparse(int argc, const char_type* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+
+      flags_container                          const& flags()    const;
+      params_container                         const& params()   const { return params_;   }
+      params_range                                    params(string_type const& name) const;
+      pos_args_container                       const& pos_args() const { return pos_args_; }
+
+      // the args left unparsed: from the subcommand that stopped the parsing, or after "--" in DOUBLE_DASH_ENDS_OPTIONS mode.
+      // Empty when parsing went through all the args.
+      args_range                                      remainder() const;
+
+      // the one-char flags of the last parse (-v, or the letters of -xvf in SINGLE_DASH_IS_MULTIFLAG mode) in the order
+      // they were first given, with their counts. The parse only counts these: flags() has them too, but stores them,
+      // one element per occurrence, at its first call after the parse. Call it once before sharing the parser between
+      // threads, or use this and operator[], which never store anything.
+      byte_flags_container                     const& byte_flags() const { return byte_flag_list_; }
+
+      // a snapshot of the last parse: flags, params, positional args, remainder and fallback values, in one
+      // position-independent blob that argh::frozen_parser (C++17) reads in place, e.g. from shared memory or a file.
+      // Aliases are not kept, the snapshot is looked up by canonical names. Only parsers of char can be serialized.
+      // Throws std::length_error if the parse has more than 4 GiB of strings, or 2^32 args, which 32-bit refs cannot hold.
+      std::string serialize() const;
+
+      // a 64-bit hash of the last parse, computed while parsing: the flags and params in any order, the positional args
+      // and the remainder in order, and the fallback values. Equal command lines, whatever the order of their options,
+      // have equal fingerprints, in any process and on any machine for parsers of char.
+      uint64_t fingerprint() const { return fingerprint_; }
+
+      // leaves flags and params out of the fingerprints of the next parses, e.g. "verbose" or "jobs"
+      void exclude_from_fingerprint(std::initializer_list<char_type const* const> names);
+
+#if defined(ARGH_HAS_STRING_VIEW)
+      // an immutable copy of the last parse, for many threads to read: a snapshot with the hash index of its names,
+      // see frozen_parser. The const accessors of a parser only modify it at their first call after a parse: flags()
+      // stores the one-char flags, the accessors by key keep what the key is looked up to (and all count lookups with
+      // ARGH_ENABLE_STATS), while a frozen_parser has its strings and tables in a few contiguous blocks.
+      std::shared_ptr<frozen_parser const> freeze() const;
+#endif
+
+      // a variant of the last parse that records only what it changes, see basic_overlay. Takes no time to make;
+      // this parser must outlive the overlay, and not be parsed again while it is in use.
+      basic_overlay<basic_parser> overlay() const;
+
+#if defined(ARGH_ENABLE_STATS)
+      // what the last parse classified, the lookups made since, and the memory held now. Allocations are counted
+      // by the parser's allocator, e.g. a pmr_parser over an argh::counting_resource.
+      parse_stats stats() const;
+#endif
+
+      // begin() and end() for using range-for over positional args.
+      typename pos_args_container::const_iterator begin() const { return pos_args_.cbegin(); }
+      typename pos_args_container::const_iterator end()   const { return pos_args_.cend();   }
+      size_t size()                                       const { return pos_args_.size();   }
+
+      //////////////////////////////////////////////////////////////////////////
+      // Accessors
+
+      // flag (boolean) accessors: return true if the flag appeared, otherwise false.
+      bool operator[](string_type const& name) const;
+
+      // multiple flag (boolean) accessors: return true if at least one of the flag appeared, otherwise false.
+      bool operator[](std::initializer_list<char_type const* const> init_list) const;
+
+      // returns positional arg string by order. Like argv[] but without the options
+      string_type const& operator[](size_t ind) const;
+
+      // returns a std::istream that can be used to convert a positional arg to a typed value.
+      stream_type operator()(size_t ind) const;
+
+      // same as above, but with a default value in case the arg is missing (index out of range).
+      template<typename T>
+      stream_type operator()(size_t ind, T&& def_val) const;
+
+      // parameter accessors, give a name get an std::istream that can be used to convert to a typed value.
+      // call .str() on result to get as string
+      stream_type operator()(string_type const& name) const;
+
+      // accessor for a parameter with multiple names, give a list of names, get an std::istream that can be used to convert to a typed value.
+      // call .str() on result to get as string
+      // returns the first value in the list to be found.
+      stream_type operator()(std::initializer_list<char_type const* const> init_list) const;
+
+      // same as above, but with a default value in case the param was missing.
+      // Non-string def_val types must have an operator<<() (output stream operator)
+      // If T only has an input stream operator, pass the string version of the type as in "3" instead of 3.
+      template<typename T>
+      stream_type operator()(string_type const& name, T&& def_val) const;
+
+      // same as above but for a list of names. returns the first value to be found.
+      template<typename T>
+      stream_type operator()(std::initializer_list<char_type const* const> init_list, T&& def_val) const;
+
+      // typed accessors, convert a parameter or positional arg without going through an std::istream.
+      // integers, floating point values ("1.5") and bools ("1", "0", "true", "false") are converted directly,
+      // the whole arg must convert. Other types are read with operator>>().
+      template<typename T>
+      result<T> get(string_type const& name) const;
+
+      // same as above, returns the first value in the list to be found.
+      template<typename T>
+      result<T> get(std::initializer_list<char_type const* const> init_list) const;
+
+      // same as above, for a positional arg by order.
+      template<typename T>
+      result<T> get(size_t ind) const;
+
+      // list accessors: split every value of a param on sep, convert each element like get<T>() does and append
+      // them to out, in order of appearance, e.g. "--ids=1,2 --ids 3" gives 1, 2, 3 when ids is a registered param.
+      // out is reserved for all the elements first. Returns MISSING if the param is missing, or BAD_CONVERSION
+      // at the first element that does not convert, out then holds the elements before it.
+      template<typename T, typename Alloc>
+      get_status get_list(string_type const& name, std::vector<T, Alloc>& out, char_type sep = ',') const;
+
+      // same as above, in a new vector
+      template<typename T>
+      result<std::vector<T>> get_list(string_type const& name, char_type sep = ',') const;
+
+      // typed accessors with a default: def_val is returned as is when the arg is missing or does not convert,
+      // without formatting it to a stream first. Only a present arg is converted, as with get<T>().
+      template<typename T>
+      T value_or(string_type const& name, T def_val) const;
+
+      // same as above, converts the first value in the list to be found.
+      template<typename T>
+      T value_or(std::initializer_list<char_type const* const> init_list, T def_val) const;
+
+      // same as above, for a positional arg by order.
+      template<typename T>
+      T value_or(size_t ind, T def_val) const;
+
+      // same as the accessors by name above, for the name registered as k
+      template<typename T>
+      T value_or(key k, T def_val) const;
+
+      // the same with a string default, e.g. value_or("out", "a.out"): the arg as it is, or def_val
+      string_type value_or(string_type const& name, char_type const* def_val) const;
+      string_type value_or(std::initializer_list<char_type const* const> init_list, char_type const* def_val) const;
+      string_type value_or(size_t ind, char_type const* def_val) const;
+      string_type value_or(key k, char_type const* def_val) const;
+      bool operator[](key k) const;
+      stream_type operator()(key k) const;
+      template<typename T>
+      stream_type operator()(key k, T&& def_val) const;
+      template<typename T>
+      result<T> get(key k) const;
+
+   private:
+      friend class incremental_parser;
+      template<typename Parser>
+      friend class basic_overlay;
+
+      // a name and value of the fallback layers, in the environment snapshot or a source
+      struct fallback_entry
+      {
+         char_type const* name;
+         size_t name_size;
+         char_type const* value;
+         size_t value_size;
+      };
+
+      // a param value found by a lookup: an arg of the command line, or a value of the fallback layers
+      struct param_value
+      {
+         string_type const* arg = nullptr;
+         fallback_entry const* fallback = nullptr;
+
+         explicit operator bool() const { return arg || fallback; }
+         char_type const* first() const { return arg ? arg->data() : fallback->value; }
+         char_type const* last()  const { return arg ? arg->data() + arg->size() : fallback->value + fallback->value_size; }
+      };
+
+      void clear_results();
+      void parse_args(int argc, int mode);
+      template<typename It>
+      size_t pool_args(It first, It last);
+      void end_parse(size_t count);
+      void store_byte_flags() const;
+      uint64_t combine_fingerprint() const;
+      void clear_byte_flags();
+      bool got_byte_flag(int byte) const { return 0 != (byte_flags_[byte >> 6] & (uint64_t(1) << (byte & 63))); }
+      void snapshot_env(std::true_type /*narrow chars*/);
+      void snapshot_env(std::false_type) {}
+      bool add_source(char const* path, std::true_type /*narrow chars*/);
+      bool add_source(char const*, std::false_type) { return false; }
+      void index_sources(std::true_type /*narrow chars*/);
+      void index_sources(std::false_type) {}
+      void layer_sources();
+      static int compare_name(fallback_entry const& entry, char_type const* name, size_t size);
+      size_t expand_response_files(size_t argc, std::true_type /*narrow chars*/);
+      size_t expand_response_files(size_t argc, std::false_type) { return argc; }
+      bool append_response_file(size_t& count, std::string const& path, std::vector<detail::response_file::id_type>& chain);
+      string_type& next_expanded_arg(size_t& count);
+      void store_flag(slice_type const& name);
+      void store_pos_arg(string_type const& arg);
+      bool fingerprinted(slice_type const& name) const;
+      template<typename Value>
+      void store_param(slice_type const& name, Value const& value);
+      stream_type bad_stream() const;
+      template<typename T>
+      static result<T> convert(string_type const& arg);
+      template<typename T>
+      static result<T> convert(param_value const& value);
+      template<typename T>
+      static T convert_or(char_type const* first, char_type const* last, T& def_val);
+      static stream_type make_stream(param_value const& value);
+      static string_type string_or(param_value const& value, char_type const* def_val);
+      template<typename Values, typename T, typename Alloc>
+      static get_status split_list(Values const& values, std::vector<T, Alloc>& out, char_type sep);
+      template<typename S>
+      static S trim_leading_dashes(S const& name) { return detail::trim_leading_dashes(name); }
+      static string_type const& lookup_name(string_type const& name, string_type& storage);
+      static string_type const& lookup_name(char_type const* name, string_type& storage);
+      template<typename Name>
+      bool got_flag(Name const& name) const;
+      template<typename Name>
+      param_value find_param(Name const& name) const;
+      param_value find_canonical_param(string_type const& name) const;
+      void add_alias(slice_type const& name, slice_type const& canonical);
+      string_type const* find_alias(slice_type const& name) const;
+      string_type const& canonical(string_type const& name) const { auto const alias = find_alias(name); return alias ? *alias : name; }
+      key add_key(slice_type const& name);
+      owned_string const* key_name(key k) const { return k.index_ < names_by_key_.size() ? &names_by_key_[k.index_] : nullptr; }
+      param_value find_value(key k) const;
+      bool is_param(slice_type const& name) const;
+      bool is_flag(slice_type const& name) const;
+
+      // in MATCH_UNIQUE_PREFIX mode, the registered name that an unregistered name is the only prefix of
+      struct prefix_match
+      {
+         owned_string const* name = nullptr;
+         bool param = false;
+      };
+      prefix_match match_prefix(slice_type const& name) const;
+      slice_type expand_prefix(slice_type const& name);
+#if defined(ARGH_ENABLE_STATS)
+      void count_arg(string_type const& arg, detail::arg_kind kind);
+      void count_lookup(bool found) const { ++stats_.lookups; stats_.lookup_misses += !found; }
+#endif
+      bool is_subcommand(string_type const& arg) const;
+
+      // forwards what detail::scan_args() finds to the store functions
+      struct arg_sink
+      {
+         basic_parser& parser;
+         bool is_param(slice_type const& name) const            { return parser.is_param(name); }
+         bool is_flag(slice_type const& name) const             { return parser.is_flag(name); }
+         bool is_subcommand(string_type const& arg) const       { return parser.is_subcommand(arg); }
+         void flag(slice_type const& name)                      { parser.store_flag(name); }
+         template<typename Value>
+         void param(slice_type const& name, Value const& value) { parser.store_param(name, value); }
+         void positional(string_type const& arg)                { parser.store_pos_arg(arg); }
+#if defined(ARGH_ENABLE_STATS)
+         void classified(string_type const& arg, detail::arg_kind kind) { parser.count_arg(arg, kind); }
+#endif
+      };
+
+   private:
+#if defined(ARGH_HAS_STRING_VIEW)
+      // transparent comparison, so a string_view name can be looked up without a copy
+      using registered_params_container = typename Storage::template set<owned_string, std::less<>>;
+#else
+      using registered_params_container = typename Storage::template set<owned_string, std::less<owned_string>>;
+#endif
+
+      template<typename Container>
+      using spares_container = detail::spare_list<typename Storage::template vector<typename detail::spare_of<Container>::type>>;
+
+      pos_args_container args_;
+      typename Storage::template vector<typename string_type::value_type> line_; // split by parse_string(), or the pooled args
+      params_container params_;
+      pos_args_container pos_args_;
+      mutable flags_container flags_; // without the one-char flags until flags() stores them
+      registered_params_container registeredParams_;
+      registered_params_container registeredSubcommands_;
+      registered_params_container registeredFlags_;
+
+      // the names registered with a key, by key, the keys sorted by name, and what each key resolved to: looked up
+      // at the first access by key after a parse, the parse_generation_ of which is then kept with the result
+      struct key_state
+      {
+         size_t flag_generation = 0;
+         size_t value_generation = 0;
+         bool flag = false;
+         param_value value;
+      };
+      typename Storage::template vector<owned_string> names_by_key_;
+      typename Storage::template vector<size_t> sorted_keys_;
+      mutable typename Storage::template vector<key_state> key_states_;
+      size_t parse_generation_ = 0;
+      detail::owner_mark resolved_; // key_states_ point into this parser's params_ and fallback_
+
+      ARGH_STATS(mutable parse_stats stats_;)
+
+      // the aliases sorted by name, and the canonical name of each
+      typename Storage::template vector<owned_string> alias_names_;
+      typename Storage::template vector<string_type> alias_canonicals_;
+
+      size_t remainder_first_ = 0;
+      size_t remainder_last_ = 0;
+      string_type empty_;
+
+      // the values of the params missing from the command line, sorted by name, one entry per name: the environment
+      // read by the last parse if env_prefix_ is set, over the entries of the sources. They refer into env_values_ and
+      // sources_, shared by the copies of the parser. env_values_ is refilled in place unless a copy still refers to it.
+      bool env_enabled_ = false;
+      owned_string env_prefix_;
+      std::shared_ptr<owned_string> env_values_;
+      typename Storage::template vector<size_t> env_bounds_; // name first, value first, for each variable found, and the end
+      std::string env_name_;
+      typename Storage::template vector<fallback_entry> fallback_;
+      typename Storage::template vector<fallback_entry> merged_fallback_; // swapped with fallback_ by layer_sources()
+
+      // the mapped sources in the order added, and their entries sorted by name, split at the first parse after add_source()
+      typename Storage::template vector<std::shared_ptr<detail::response_file>> sources_;
+      typename Storage::template vector<fallback_entry> source_entries_;
+      bool sources_indexed_ = true;
+
+      // the one-char flags (-v, or the letters of -xvf in SINGLE_DASH_IS_MULTIFLAG mode) of the last parse:
+      // a bit per byte value, and how many times each was given. They are only stored into flags_ when flags() is
+      // called, the accessors by name test the bits instead of searching flags_.
+      uint64_t byte_flags_[4] = {};
+      unsigned char byte_flag_slots_[256] = {}; // where byte_flag_list_ holds the byte values with a bit set
+      byte_flags_container byte_flag_list_;     // the names of a parser owning its strings are in detail::byte_chars()
+      mutable bool byte_flags_stored_ = true;
+
+      // the hashes of the flags and params summed, so that their order does not count, and of the positional args
+      // chained. fingerprint_ combines them at the end of the parse.
+      struct fingerprint_hashes
+      {
+         uint64_t flags = 0;
+         uint64_t pos_args = 0;
+      };
+      fingerprint_hashes hashes_;
+      uint64_t fingerprint_ = 0;
+
+      bool prefix_matching_ = false; // MATCH_UNIQUE_PREFIX, for the current parse
+      registered_params_container fingerprint_exclusions_;
+
+      // elements kept by reparse()
+      spares_container<params_container> spare_params_;
+      spares_container<pos_args_container> spare_pos_args_;
+      mutable spares_container<flags_container> spare_flags_;
+
+      // the response files args_ were expanded from, that a view_parser refers into. Shared by copies.
+      typename Storage::template vector<std::shared_ptr<detail::response_file>> response_files_;
+
+      // the args expanded from response files, swapped with args_: the strings of both keep their capacity for later
+      pos_args_container expanded_args_;
+
+      // the registered names abbreviations were expanded to, that a view_parser refers into. Shared by copies.
+      std::shared_ptr<std::set<owned_string>> expanded_names_;
+   };
+
+   // parser, view_parser, pooled_parser and their flat variants are declared in argh_fwd.h
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+   using pmr_parser = basic_parser<std::pmr::string, pmr_storage>;
+   using pmr_flat_parser = basic_parser<std::pmr::string, pmr_flat_storage>;
+#endif
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::parse(const char_type* const argv[], int mode)
+   {
+      int argc = 0;
+      for (auto argvp = argv; *argvp; ++argc, ++argvp);
+      parse(argc, argv, mode);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::parse(int argc, const char_type* const argv[], int mode /*= PREFER_FLAG_FOR_UNREG_OPTION*/)
+   {
+      clear_results();
+
+      // convert to strings
+      args_.resize(static_cast<typename pos_args_container::size_type>(argc));
+      if (detail::pools_args<Storage>::value)
+         pool_args(argv, argv + argc);
+      else
+         std::transform(argv, argv + argc, args_.begin(), [](const char_type* const arg) { return arg;  });
+
+      parse_args(argc, mode);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::parse_string(slice_type const& line, int mode /*= PREFER_FLAG_FOR_UNREG_OPTION*/)
+   {
+      clear_results();
+
+      // the parts are unquoted in place in line_, then copied to args_ (or referred to by a view_parser)
+      line_.assign(line.begin(), line.end());
+      size_t argc = 0;
+      auto const closed = detail::split_command_line(line_.data(), line_.data() + line_.size(),
+         [&](typename string_type::value_type* first, typename string_type::value_type* last)
+         {
+            if (args_.size() == argc)
+               args_.emplace_back();
+            detail::assign_range(args_[argc++], first, last);
+         });
+
+      parse_args(static_cast<int>(argc), mode);
+      return closed;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename It>
+   inline void basic_parser<String, Storage>::parse(It first, It last, int mode /*= PREFER_FLAG_FOR_UNREG_OPTION*/)
+   {
+      clear_results();
+
+      if (detail::pools_args<Storage>::value)
+      {
+         parse_args(static_cast<int>(pool_args(first, last)), mode);
+         return;
+      }
+
+      size_t argc = 0;
+      for (; first != last; ++first, ++argc)
+      {
+         if (args_.size() == argc)
+            args_.emplace_back();
+         auto const data = detail::arg_data(*first);
+         detail::assign_range(args_[argc], data, data + detail::arg_size(*first));
+      }
+
+      parse_args(static_cast<int>(argc), mode);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::clear_results()
+   {
+      // clear out possible previous parsing remnants
+      flags_.clear();
+      params_.clear();
+      pos_args_.clear();
+      spare_flags_.clear();
+      spare_params_.clear();
+      spare_pos_args_.clear();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::reparse(const char_type* const argv[], int mode)
+   {
+      int argc = 0;
+      for (auto argvp = argv; *argvp; ++argc, ++argvp);
+      reparse(argc, argv, mode);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::reparse(int argc, const char_type* const argv[], int mode /*= PREFER_FLAG_FOR_UNREG_OPTION*/)
+   {
+      detail::clear_into(flags_, spare_flags_);
+      detail::clear_into(params_, spare_params_);
+      detail::clear_into(pos_args_, spare_pos_args_);
+
+      // args_ never shrinks here, so that the strings past argc keep their capacity for later
+      if (args_.size() < static_cast<typename pos_args_container::size_type>(argc))
+         args_.resize(static_cast<typename pos_args_container::size_type>(argc));
+      if (detail::pools_args<Storage>::value)
+         pool_args(argv, argv + argc);
+      else
+         std::transform(argv, argv + argc, args_.begin(), [](const char_type* const arg) { return arg;  });
+
+      parse_args(argc, mode);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // copies the args, each followed by a '\0', into line_, resized once to their total length, and points the
+   // first args_ at them. Returns the arg count. Walks the args twice, so It must be a forward iterator.
+   template<typename String, typename Storage>
+   template<typename It>
+   inline size_t basic_parser<String, Storage>::pool_args(It first, It last)
+   {
+      size_t argc = 0;
+      size_t total = 0;
+      for (auto it = first; it != last; ++it, ++argc)
+         total += detail::arg_size(*it) + 1;
+
+      line_.resize(total);
+      if (args_.size() < argc)
+         args_.resize(argc);
+
+      auto pool = line_.data();
+      for (size_t i = 0; first != last; ++first, ++i)
+      {
+         auto const size = detail::arg_size(*first);
+         traits_type::copy(pool, detail::arg_data(*first), size);
+         pool[size] = char_type();
+         detail::assign_range(args_[i], pool, pool + size);
+         pool += size + 1;
+      }
+      return argc;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // parses the first argc args_
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::parse_args(int argc, int mode)
+   {
+      auto count = static_cast<size_t>(argc);
+      ARGH_STATS(stats_ = parse_stats();)
+      clear_byte_flags();
+      hashes_ = fingerprint_hashes();
+      prefix_matching_ = 0 != (mode & MATCH_UNIQUE_PREFIX);
+      response_files_.clear();
+      if (mode & EXPAND_RESPONSE_FILES)
+         count = expand_response_files(count, std::is_same<char_type, char>());
+
+      arg_sink sink{ *this };
+      remainder_first_ = detail::scan_args<slice_type>(args_, count, mode, sink);
+      end_parse(count);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // ends the remainder at count, then looks up what the accessors need
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::end_parse(size_t count)
+   {
+      remainder_last_ = count;
+      detail::sort_recycled(flags_);
+      detail::sort_recycled(params_);
+      for (auto const& flag : byte_flag_list_)
+      {
+         if (fingerprint_exclusions_.empty() || fingerprinted(slice_type(flag.name, 1)))
+            hashes_.flags += flag.count * detail::hash_bytes(flag.name, sizeof(char_type), detail::flag_seed);
+      }
+      byte_flags_stored_ = byte_flag_list_.empty();
+
+      fallback_.clear();
+      if (env_enabled_)
+         snapshot_env(std::is_same<char_type, char>());
+      if (!sources_.empty())
+         layer_sources();
+      fingerprint_ = combine_fingerprint();
+      if (key_states_.size() < names_by_key_.size())
+         key_states_.resize(names_by_key_.size());
+      ++parse_generation_; // the keys resolved by the last parse are stale
+      resolved_.owner = this;
+      ARGH_STATS(stats_.lookups = stats_.lookup_misses = 0;)
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::flags_container const& basic_parser<String, Storage>::flags() const
+   {
+      if (!byte_flags_stored_)
+         store_byte_flags();
+      return flags_;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // stores the one-char flags counted by the parse into flags_, an element per occurrence
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::store_byte_flags() const
+   {
+      for (auto const& flag : byte_flag_list_)
+      {
+         slice_type const name(flag.name, 1);
+         for (auto n = flag.count; 0 < n; --n)
+            detail::emplace_recycled(flags_, spare_flags_, name);
+      }
+      detail::sort_recycled(flags_);
+      byte_flags_stored_ = true;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline uint64_t basic_parser<String, Storage>::combine_fingerprint() const
+   {
+      // names in any order, but the values of each in order: p(name) is the first one
+      uint64_t params_hash = 0;
+      for (auto it = params_.begin(); params_.end() != it;)
+      {
+         auto const& name = it->first;
+         auto const counted = fingerprint_exclusions_.empty() || fingerprinted(slice_type(name));
+         auto values_hash = detail::hash_string(name, detail::param_seed);
+         for (; params_.end() != it && it->first == name; ++it)
+            values_hash = detail::hash_string(it->second, values_hash);
+         if (counted)
+            params_hash += values_hash;
+      }
+
+      auto remainder_hash = uint64_t(detail::remainder_seed);
+      for (auto const& arg : remainder())
+         remainder_hash = detail::hash_string(arg, remainder_hash);
+
+      uint64_t fallback_hash = 0;
+      for (auto const& entry : fallback_)
+      {
+         if (!fingerprint_exclusions_.empty() && !fingerprinted(slice_type(entry.name, entry.name_size)))
+            continue;
+         auto const name_hash = detail::hash_bytes(entry.name, entry.name_size * sizeof(char_type), detail::fallback_seed);
+         fallback_hash += detail::hash_bytes(entry.value, entry.value_size * sizeof(char_type), name_hash);
+      }
+
+      auto const options = detail::mix_mul(hashes_.flags ^ 0x9E3779B97F4A7C15ULL, params_hash ^ 0xC2B2AE3D27D4EB4FULL);
+      auto const args = detail::mix_mul(hashes_.pos_args ^ 0x165667B19E3779F9ULL, remainder_hash ^ 0x27D4EB2F165667C5ULL);
+      return detail::mix_mul(options ^ fallback_hash, args ^ 0x85EBCA77C2B2AE63ULL);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::fingerprinted(slice_type const& name) const
+   {
+      return fingerprint_exclusions_.end() == fingerprint_exclusions_.find(name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::exclude_from_fingerprint(std::initializer_list<char_type const* const> names)
+   {
+      for (auto& name : names)
+      {
+         auto const trimmed_name = trim_leading_dashes(slice_type(name));
+         auto const alias = find_alias(trimmed_name);
+         if (alias)
+            fingerprint_exclusions_.emplace(slice_type(*alias));
+         else
+            fingerprint_exclusions_.emplace(trimmed_name);
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::store_pos_arg(string_type const& arg)
+   {
+      detail::emplace_recycled(pos_args_, spare_pos_args_, arg);
+      hashes_.pos_args = detail::hash_string(arg, hashes_.pos_args ^ detail::pos_arg_seed);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::clear_byte_flags()
+   {
+      byte_flag_list_.clear();
+      byte_flags_stored_ = true;
+      std::fill(std::begin(byte_flags_), std::end(byte_flags_), uint64_t(0));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+
+   // reads the environment variables of the registered params into fallback_
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::snapshot_env(std::true_type)
+   {
+      if (env_values_ && 1 == env_values_.use_count())
+      {
+         env_values_->clear();
+      }
+      else
+      {
+         // a polymorphic_allocator also passes itself to the string
+         env_values_ = std::allocate_shared<owned_string>(allocator_type(fallback_.get_allocator()));
+      }
+
+      auto& values = *env_values_;
+      auto& bounds = env_bounds_;
+      bounds.clear();
+      for (auto const& name : registeredParams_)
+      {
+         if (find_alias(name))
+            continue; // read as its canonical name
+
+         env_name_.assign(env_prefix_.begin(), env_prefix_.end());
+         for (auto const c : name)
+            env_name_ += '-' == c ? '_' : static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+         auto const value = std::getenv(env_name_.c_str());
+         if (!value)
+            continue;
+
+         bounds.push_back(values.size());
+         values.append(name.begin(), name.end());
+         bounds.push_back(values.size());
+         values.append(value);
+      }
+      bounds.push_back(values.size());
+
+      // the names are sorted already, registeredParams_ is
+      auto const data = values.data();
+      for (size_t i = 0; i + 2 < bounds.size(); i += 2)
+         fallback_.push_back(fallback_entry{ data + bounds[i], bounds[i + 1] - bounds[i], data + bounds[i + 1], bounds[i + 2] - bounds[i + 1] });
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::set_env_prefix(slice_type const& prefix)
+   {
+      detail::assign_range(env_prefix_, prefix.data(), prefix.data() + prefix.size());
+      env_enabled_ = true;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::add_source(char const* path, std::true_type)
+   {
+      auto file = std::make_shared<detail::response_file>(path);
+      if (!*file)
+         return false;
+      sources_.push_back(std::move(file));
+      sources_indexed_ = false;
+      return true;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // splits the sources into source_entries_: one entry per key, from the last line of the last source that has it.
+   // Blank lines and lines starting with # or ; are skipped, and so are lines without '='. The keys and values are
+   // trimmed, and the keys of their leading dashes.
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::index_sources(std::true_type)
+   {
+      auto const is_space = [](char c) { return ' ' == c || '\t' == c || '\r' == c || '\v' == c || '\f' == c; };
+      auto const trim = [&](char const*& first, char const*& last)
+      {
+         while (first != last && is_space(*first))
+            ++first;
+         while (first != last && is_space(last[-1]))
+            --last;
+      };
+
+      source_entries_.clear();
+      std::vector<fallback_entry> lines;
+      for (auto it = sources_.rbegin(); it != sources_.rend(); ++it)
+      {
+         char const* const end = (*it)->end();
+         lines.clear();
+         for (char const* line = (*it)->begin(); line != end; )
+         {
+            auto const eol = std::find(line, end, '\n');
+            auto first = line, last = eol;
+            line = end == eol ? end : eol + 1;
+
+            trim(first, last);
+            if (first == last || '#' == *first || ';' == *first)
+               continue;
+            auto const eq = std::find(first, last, '=');
+            if (last == eq)
+               continue;
+
+            auto key_last = eq, value_first = eq + 1;
+            trim(first, key_last);
+            trim(value_first, last);
+            while (first != key_last && '-' == *first)
+               ++first;
+            if (first != key_last)
+               lines.push_back(fallback_entry{ first, static_cast<size_t>(key_last - first), value_first, static_cast<size_t>(last - value_first) });
+         }
+         source_entries_.insert(source_entries_.end(), lines.rbegin(), lines.rend());
+      }
+
+      // the entries are in decreasing precedence: keep the first one of each name
+      auto const less = [](fallback_entry const& a, fallback_entry const& b) { return compare_name(a, b.name, b.name_size) < 0; };
+      std::stable_sort(source_entries_.begin(), source_entries_.end(), less);
+      source_entries_.erase(std::unique(source_entries_.begin(), source_entries_.end(),
+         [](fallback_entry const& a, fallback_entry const& b) { return 0 == compare_name(a, b.name, b.name_size); }), source_entries_.end());
+      sources_indexed_ = true;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // merges the entries of the sources under the environment snapshot in fallback_
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::layer_sources()
+   {
+      if (!sources_indexed_)
+         index_sources(std::is_same<char_type, char>());
+      if (fallback_.empty())
+      {
+         fallback_.assign(source_entries_.begin(), source_entries_.end());
+         return;
+      }
+
+      auto env = fallback_.begin();
+      auto const env_end = fallback_.end();
+      auto& merged = merged_fallback_;
+      merged.clear();
+      merged.reserve(fallback_.size() + source_entries_.size());
+      for (auto const& entry : source_entries_)
+      {
+         int order = 1;
+         while (env != env_end && (order = compare_name(*env, entry.name, entry.name_size)) < 0)
+            merged.push_back(*env++);
+         if (0 != order)
+            merged.push_back(entry);
+      }
+      merged.insert(merged.end(), env, env_end);
+      fallback_.swap(merged);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline int basic_parser<String, Storage>::compare_name(fallback_entry const& entry, char_type const* name, size_t size)
+   {
+      auto const order = traits_type::compare(entry.name, name, (std::min)(entry.name_size, size));
+      if (0 != order)
+         return order;
+      return entry.name_size < size ? -1 : (entry.name_size > size ? 1 : 0);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // replaces the @path args among the first argc args_ with the contents of the files, returns the new arg count.
+   // An @path that cannot be read, or that is already being expanded, is kept as it is.
+   // Parsers of wider chars do not expand response files.
+   template<typename String, typename Storage>
+   inline size_t basic_parser<String, Storage>::expand_response_files(size_t argc, std::true_type)
+   {
+      auto const is_response_file = [](string_type const& arg) { return 1 < arg.size() && '@' == arg[0]; };
+      auto const args_end = args_.begin() + static_cast<std::ptrdiff_t>(argc);
+      if (std::none_of(args_.begin(), args_end, is_response_file))
+         return argc;
+
+      size_t count = 0;
+      std::vector<detail::response_file::id_type> chain;
+      for (auto it = args_.begin(); it != args_end; ++it)
+      {
+         if (!is_response_file(*it) || !append_response_file(count, std::string(it->begin() + 1, it->end()), chain))
+         {
+            using std::swap;
+            swap(next_expanded_arg(count), *it);
+         }
+      }
+      args_.swap(expanded_args_);
+      return count;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // the count-th expanded arg, recycled from an earlier parse if it has one
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type& basic_parser<String, Storage>::next_expanded_arg(size_t& count)
+   {
+      if (expanded_args_.size() == count)
+         expanded_args_.emplace_back();
+      return expanded_args_[count++];
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // appends the args of the response file at path to the count expanded args, expanding nested response files.
+   // chain holds the files being expanded, a file found in there again is not expanded.
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::append_response_file(size_t& count, std::string const& path, std::vector<detail::response_file::id_type>& chain)
+   {
+      auto file = std::make_shared<detail::response_file>(path.c_str());
+      if (!*file || chain.end() != std::find(chain.begin(), chain.end(), file->id()))
+         return false;
+
+      chain.push_back(file->id());
+      detail::split_command_line(file->begin(), file->end(), [&](char* first, char* last)
+      {
+         if (1 < last - first && '@' == *first && append_response_file(count, std::string(first + 1, last), chain))
+            return;
+         detail::assign_range(next_expanded_arg(count), first, last);
+      });
+      chain.pop_back();
+
+      response_files_.push_back(std::move(file));
+      return true;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::bad_stream() const
+   {
+      stream_type bad;
+      bad.setstate(std::ios_base::failbit);
+      return bad;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // the name to search for: name itself when it has no leading dashes, otherwise its trimmed copy in storage
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type const& basic_parser<String, Storage>::lookup_name(string_type const& name, string_type& storage)
+   {
+      auto const pos = name.find_first_not_of('-');
+      if (0 == pos || string_type::npos == pos)
+         return name;
+      detail::assign_range(storage, name.data() + pos, name.data() + name.size());
+      return storage;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type const& basic_parser<String, Storage>::lookup_name(char_type const* name, string_type& storage)
+   {
+      auto first = name;
+      while ('-' == *first)
+         ++first;
+      if (!*first)
+         first = name; // all dashes, kept as is
+      detail::assign_range(storage, first, first + traits_type::length(first));
+      return storage;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename Name>
+   inline bool basic_parser<String, Storage>::got_flag(Name const& name) const
+   {
+      // converted once, and kept alive here: canonical_name may refer to it, e.g. a std::string name of a view_parser
+      string_type const& typed_name = name;
+      string_type storage;
+      auto const& canonical_name = canonical(lookup_name(typed_name, storage));
+      auto const byte = detail::byte_name(canonical_name);
+      auto const found = 0 <= byte ? got_byte_flag(byte) : flags_.end() != flags_.find(canonical_name);
+      ARGH_STATS(count_lookup(found);)
+      return found;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename Name>
+   inline typename basic_parser<String, Storage>::param_value basic_parser<String, Storage>::find_param(Name const& name) const
+   {
+      string_type storage;
+      return find_canonical_param(canonical(lookup_name(name, storage)));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // the first value of the param on the command line, otherwise in the fallback layers
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::param_value basic_parser<String, Storage>::find_canonical_param(string_type const& name) const
+   {
+      param_value value;
+      auto const optIt = params_.find(name);
+      if (params_.end() != optIt)
+      {
+         value.arg = &optIt->second;
+      }
+      else if (!fallback_.empty())
+      {
+         auto const pos = std::lower_bound(fallback_.begin(), fallback_.end(), name,
+            [](fallback_entry const& entry, string_type const& n) { return compare_name(entry, n.data(), n.size()) < 0; });
+         if (fallback_.end() != pos && 0 == compare_name(*pos, name.data(), name.size()))
+            value.fallback = &*pos;
+      }
+      ARGH_STATS(count_lookup(bool(value));)
+      return value;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // the value of the param registered as k
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::param_value basic_parser<String, Storage>::find_value(key k) const
+   {
+      if (names_by_key_.size() <= k.index_)
+         return param_value();
+      if (this != resolved_.owner || key_states_.size() <= k.index_)
+         return find_param(names_by_key_[k.index_]); // copied, moved or not parsed since the key was added: search
+
+      auto& state = key_states_[k.index_];
+      if (parse_generation_ != state.value_generation)
+      {
+         state.value = find_param(names_by_key_[k.index_]);
+         state.value_generation = parse_generation_;
+         return state.value;
+      }
+      ARGH_STATS(count_lookup(bool(state.value));)
+      return state.value;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::store_flag(slice_type const& typed_name)
+   {
+      auto const name = prefix_matching_ ? expand_prefix(typed_name) : typed_name;
+      auto const alias = find_alias(name);
+      auto const& canonical_name = alias ? *alias : name;
+      auto const byte = detail::byte_name(canonical_name); // got_flag() looks one-char canonical names up in the bitmap
+      if (byte < 0)
+      {
+         if (alias)
+            detail::emplace_recycled(flags_, spare_flags_, *alias);
+         else
+            detail::emplace_recycled(flags_, spare_flags_, name);
+         if (fingerprint_exclusions_.empty() || fingerprinted(canonical_name))
+            hashes_.flags += detail::hash_string(canonical_name, detail::flag_seed);
+         return;
+      }
+
+      if (!got_byte_flag(byte))
+      {
+         byte_flags_[byte >> 6] |= uint64_t(1) << (byte & 63);
+         byte_flag_slots_[byte] = static_cast<unsigned char>(byte_flag_list_.size());
+         bool const owning = std::is_same<owned_string, string_type>::value;
+         byte_flag_list_.push_back(byte_flag{ owning ? detail::byte_chars<char_type>() + byte : canonical_name.data(), 0 });
+      }
+      ++byte_flag_list_[byte_flag_slots_[byte]].count;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename Value>
+   inline void basic_parser<String, Storage>::store_param(slice_type const& typed_name, Value const& value)
+   {
+      auto const name = prefix_matching_ ? expand_prefix(typed_name) : typed_name;
+      auto const alias = find_alias(name);
+      if (alias)
+         detail::emplace_recycled(params_, spare_params_, *alias, value);
+      else
+         detail::emplace_recycled(params_, spare_params_, name, value);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // the canonical name of the alias name, nullptr if name is not an alias
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type const* basic_parser<String, Storage>::find_alias(slice_type const& name) const
+   {
+      if (alias_names_.empty())
+         return nullptr;
+      auto const pos = std::lower_bound(alias_names_.begin(), alias_names_.end(), name,
+         [](owned_string const& alias, slice_type const& n) { return slice_type(alias) < n; });
+      if (alias_names_.end() == pos || slice_type(*pos) != name)
+         return nullptr;
+      return &alias_canonicals_[static_cast<size_t>(pos - alias_names_.begin())];
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::add_alias(slice_type const& name, slice_type const& canonical)
+   {
+      auto const pos = std::lower_bound(alias_names_.begin(), alias_names_.end(), name,
+         [](owned_string const& alias, slice_type const& n) { return slice_type(alias) < n; });
+      auto const index = pos - alias_names_.begin();
+      if (alias_names_.end() != pos && slice_type(*pos) == name)
+      {
+         alias_canonicals_[static_cast<size_t>(index)] = string_type(canonical);
+         return;
+      }
+      alias_names_.emplace(pos, name);
+      alias_canonicals_.emplace(alias_canonicals_.begin() + index, canonical);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::is_param(slice_type const& name) const
+   {
+      if (registeredParams_.count(name))
+         return true;
+      return prefix_matching_ && match_prefix(name).param;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::prefix_match basic_parser<String, Storage>::match_prefix(slice_type const& name) const
+   {
+      prefix_match match;
+      if (name.empty() || registeredFlags_.count(name))
+         return match;
+
+      auto const starts_with_name = [&name](owned_string const& registered)
+      {
+         return name.size() <= registered.size() && 0 == traits_type::compare(registered.data(), name.data(), name.size());
+      };
+      auto const canonical_name = [this](owned_string const& registered)
+      {
+         auto const alias = find_alias(slice_type(registered));
+         return alias ? slice_type(*alias) : slice_type(registered);
+      };
+
+      for (auto const* names : { &registeredParams_, &registeredFlags_ })
+      {
+         for (auto it = names->lower_bound(name); names->end() != it && starts_with_name(*it); ++it)
+         {
+            if (match.name && canonical_name(*match.name) != canonical_name(*it))
+               return prefix_match(); // ambiguous
+            if (!match.name)
+               match.name = &*it, match.param = names == &registeredParams_;
+         }
+      }
+      return match;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // name, or the registered name it abbreviates
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::slice_type basic_parser<String, Storage>::expand_prefix(slice_type const& name)
+   {
+      if (!prefix_matching_ || registeredParams_.count(name))
+         return name;
+      auto const match = match_prefix(name);
+      if (!match.name)
+         return name;
+      if (std::is_same<owned_string, string_type>::value)
+         return slice_type(*match.name); // copied when stored
+
+      // a view parser stores the view, so it refers into a set of its own: the registered names may move (flat_storage)
+      if (!expanded_names_)
+         expanded_names_ = std::make_shared<std::set<owned_string>>();
+      return slice_type(*expanded_names_->insert(*match.name).first);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline std::vector<typename basic_parser<String, Storage>::owned_string> basic_parser<String, Storage>::candidates(slice_type const& prefix) const
+   {
+      auto const name = trim_leading_dashes(prefix);
+      std::vector<owned_string> found;
+      for (auto const* names : { &registeredParams_, &registeredFlags_ })
+      {
+         auto const middle = found.size();
+         for (auto it = names->lower_bound(name); names->end() != it && name.size() <= it->size()
+              && 0 == traits_type::compare(it->data(), name.data(), name.size()); ++it)
+            found.push_back(*it);
+         std::inplace_merge(found.begin(), found.begin() + static_cast<std::ptrdiff_t>(middle), found.end());
+      }
+      found.erase(std::unique(found.begin(), found.end()), found.end());
+      return found;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+#if defined(ARGH_ENABLE_STATS)
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::count_arg(string_type const& arg, detail::arg_kind kind)
+   {
+      if (!arg.empty() && '-' == arg[0])
+         ++stats_.number_checks;
+
+      switch (kind)
+      {
+      case detail::arg_kind::positional:        ++stats_.positional_args;    break;
+      case detail::arg_kind::negative_number:   ++stats_.negative_numbers;   break;
+      case detail::arg_kind::option:            ++stats_.options;            break;
+      case detail::arg_kind::option_with_value: ++stats_.options_with_value; break;
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline parse_stats basic_parser<String, Storage>::stats() const
+   {
+      auto stats = stats_;
+      stats.args_bytes = detail::retained_bytes(args_, 0) + detail::retained_bytes(expanded_args_, 0);
+      stats.pos_args_bytes = detail::retained_bytes(pos_args_, 0);
+      stats.flags_bytes = detail::retained_bytes(flags_, 0) + byte_flag_list_.capacity() * sizeof(byte_flag);
+      stats.params_bytes = detail::retained_bytes(params_, 0);
+      return stats;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+#endif
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::is_flag(slice_type const& name) const
+   {
+      if (!registeredFlags_.empty() && registeredFlags_.count(name))
+         return true;
+      if (!prefix_matching_ || registeredParams_.count(name))
+         return false;
+      auto const match = match_prefix(name);
+      return match.name && !match.param;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::is_subcommand(string_type const& arg) const
+   {
+      return !registeredSubcommands_.empty() && registeredSubcommands_.count(slice_type(arg));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::operator[](string_type const& name) const
+   {
+      return got_flag(name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::operator[](std::initializer_list<char_type const* const> init_list) const
+   {
+      return std::any_of(init_list.begin(), init_list.end(), [&](char_type const* const name) { return got_flag(name); });
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type const& basic_parser<String, Storage>::operator[](size_t ind) const
+   {
+      if (ind < pos_args_.size())
+         return pos_args_[ind];
+      return empty_;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::operator()(string_type const& name) const
+   {
+      if (auto const value = find_param(name))
+         return make_stream(value);
+      return bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::operator()(std::initializer_list<char_type const* const> init_list) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return make_stream(value);
+      }
+      return bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::operator()(string_type const& name, T&& def_val) const
+   {
+      if (auto const value = find_param(name))
+         return make_stream(value);
+
+      std::basic_ostringstream<char_type, traits_type> ostr;
+      ostr.precision(std::numeric_limits<long double>::max_digits10);
+      ostr << def_val;
+      return stream_type(ostr.str()); // use default
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // same as above but for a list of names. returns the first value to be found.
+   template<typename String, typename Storage>
+   template<typename T>
+   typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::operator()(std::initializer_list<char_type const* const> init_list, T&& def_val) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return make_stream(value);
+      }
+      std::basic_ostringstream<char_type, traits_type> ostr;
+      ostr.precision(std::numeric_limits<long double>::max_digits10);
+      ostr << def_val;
+      return stream_type(ostr.str()); // use default
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::operator()(size_t ind) const
+   {
+      if (pos_args_.size() <= ind)
+         return bad_stream();
+
+      return make_string_stream(pos_args_[ind]);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::operator()(size_t ind, T&& def_val) const
+   {
+      if (pos_args_.size() <= ind)
+      {
+         std::basic_ostringstream<char_type, traits_type> ostr;
+         ostr.precision(std::numeric_limits<long double>::max_digits10);
+         ostr << def_val;
+         return stream_type(ostr.str());
+      }
+
+      return make_string_stream(pos_args_[ind]);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   result<T> basic_parser<String, Storage>::convert(string_type const& arg)
+   {
+      T value;
+      if (!detail::convert(arg.data(), arg.data() + arg.size(), value))
+         return get_status::BAD_CONVERSION;
+      return result<T>(std::move(value));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::make_stream(param_value const& value)
+   {
+      if (value.arg)
+         return make_string_stream(*value.arg);
+      return stream_type(std::basic_string<char_type, traits_type>(value.first(), value.last()));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   result<T> basic_parser<String, Storage>::convert(param_value const& value)
+   {
+      T converted;
+      if (!detail::convert(value.first(), value.last(), converted))
+         return get_status::BAD_CONVERSION;
+      return result<T>(std::move(converted));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   result<T> basic_parser<String, Storage>::get(string_type const& name) const
+   {
+      auto const value = find_param(name);
+      if (!value)
+         return get_status::MISSING;
+      return convert<T>(value);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   result<T> basic_parser<String, Storage>::get(std::initializer_list<char_type const* const> init_list) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return convert<T>(value);
+      }
+      return get_status::MISSING;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   result<T> basic_parser<String, Storage>::get(size_t ind) const
+   {
+      if (pos_args_.size() <= ind)
+         return get_status::MISSING;
+      return convert<T>(pos_args_[ind]);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T, typename Alloc>
+   get_status basic_parser<String, Storage>::get_list(string_type const& name, std::vector<T, Alloc>& out, char_type sep /*= ','*/) const
+   {
+      return split_list(params(name), out, sep);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // splits the values of a range of (name, value) pairs into out, see get_list()
+   template<typename String, typename Storage>
+   template<typename Values, typename T, typename Alloc>
+   get_status basic_parser<String, Storage>::split_list(Values const& values, std::vector<T, Alloc>& out, char_type sep)
+   {
+      if (values.begin() == values.end())
+         return get_status::MISSING;
+
+      size_t count = 0;
+      for (auto const& value : values)
+         count += 1 + static_cast<size_t>(std::count(value.second.begin(), value.second.end(), sep));
+      out.reserve(out.size() + count);
+
+      for (auto const& value : values)
+      {
+         auto first = value.second.data();
+         auto const last = first + value.second.size();
+         for (;;)
+         {
+            auto const element_last = detail::find_char(first, last, sep);
+            T element;
+            if (!detail::convert(first, element_last, element))
+               return get_status::BAD_CONVERSION;
+            out.push_back(std::move(element));
+            if (last == element_last)
+               break;
+            first = element_last + 1;
+         }
+      }
+      return get_status::OK;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   result<std::vector<T>> basic_parser<String, Storage>::get_list(string_type const& name, char_type sep /*= ','*/) const
+   {
+      std::vector<T> values;
+      auto const status = get_list(name, values, sep);
+      if (get_status::OK != status)
+         return status;
+      return result<std::vector<T>>(std::move(values));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   T basic_parser<String, Storage>::convert_or(char_type const* first, char_type const* last, T& def_val)
+   {
+      T value;
+      if (!detail::convert(first, last, value))
+         return std::move(def_val);
+      return value;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   T basic_parser<String, Storage>::value_or(string_type const& name, T def_val) const
+   {
+      auto const value = find_param(name);
+      if (!value)
+         return def_val;
+      return convert_or(value.first(), value.last(), def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   T basic_parser<String, Storage>::value_or(std::initializer_list<char_type const* const> init_list, T def_val) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return convert_or(value.first(), value.last(), def_val);
+      }
+      return def_val;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   T basic_parser<String, Storage>::value_or(size_t ind, T def_val) const
+   {
+      if (pos_args_.size() <= ind)
+         return def_val;
+      return convert_or(pos_args_[ind].data(), pos_args_[ind].data() + pos_args_[ind].size(), def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   T basic_parser<String, Storage>::value_or(key k, T def_val) const
+   {
+      if (auto const value = find_value(k))
+         return convert_or(value.first(), value.last(), def_val);
+      return def_val;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type basic_parser<String, Storage>::string_or(param_value const& value, char_type const* def_val)
+   {
+      if (!value)
+         return string_type(def_val);
+      return string_type(value.first(), static_cast<size_t>(value.last() - value.first()));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type basic_parser<String, Storage>::value_or(string_type const& name, char_type const* def_val) const
+   {
+      return string_or(find_param(name), def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type basic_parser<String, Storage>::value_or(std::initializer_list<char_type const* const> init_list, char_type const* def_val) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return string_or(value, def_val);
+      }
+      return string_type(def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type basic_parser<String, Storage>::value_or(size_t ind, char_type const* def_val) const
+   {
+      if (pos_args_.size() <= ind)
+         return string_type(def_val);
+      return pos_args_[ind];
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::string_type basic_parser<String, Storage>::value_or(key k, char_type const* def_val) const
+   {
+      return string_or(find_value(k), def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline bool basic_parser<String, Storage>::operator[](key k) const
+   {
+      if (names_by_key_.size() <= k.index_)
+         return false;
+      if (this != resolved_.owner || key_states_.size() <= k.index_)
+         return got_flag(names_by_key_[k.index_]);
+
+      auto& state = key_states_[k.index_];
+      if (parse_generation_ != state.flag_generation)
+      {
+         state.flag = got_flag(names_by_key_[k.index_]);
+         state.flag_generation = parse_generation_;
+         return state.flag;
+      }
+      ARGH_STATS(count_lookup(state.flag);)
+      return state.flag;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::operator()(key k) const
+   {
+      if (auto const value = find_value(k))
+         return make_stream(value);
+      return bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   typename basic_parser<String, Storage>::stream_type basic_parser<String, Storage>::operator()(key k, T&& def_val) const
+   {
+      if (auto const value = find_value(k))
+         return make_stream(value);
+
+      std::basic_ostringstream<char_type, traits_type> ostr;
+      ostr.precision(std::numeric_limits<long double>::max_digits10);
+      ostr << def_val;
+      return stream_type(ostr.str()); // use default
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   template<typename T>
+   result<T> basic_parser<String, Storage>::get(key k) const
+   {
+      if (auto const value = find_value(k))
+         return convert<T>(value);
+      return get_status::MISSING;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline key basic_parser<String, Storage>::add_param(slice_type const& name)
+   {
+      auto const trimmed_name = trim_leading_dashes(name);
+      registeredParams_.emplace(trimmed_name);
+      return add_key(trimmed_name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline key basic_parser<String, Storage>::add_flag(slice_type const& name)
+   {
+      auto const trimmed_name = trim_leading_dashes(name);
+      registeredFlags_.emplace(trimmed_name);
+      return add_key(trimmed_name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // returns the key of name, adding one if name has none yet
+   template<typename String, typename Storage>
+   inline key basic_parser<String, Storage>::add_key(slice_type const& name)
+   {
+      auto const pos = std::lower_bound(sorted_keys_.begin(), sorted_keys_.end(), name,
+         [this](size_t k, slice_type const& n) { return slice_type(names_by_key_[k]) < n; });
+      if (sorted_keys_.end() != pos && slice_type(names_by_key_[*pos]) == name)
+         return key(*pos);
+
+      names_by_key_.emplace_back(name);
+      sorted_keys_.insert(pos, names_by_key_.size() - 1);
+      return key(names_by_key_.size() - 1);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::add_param(std::initializer_list<char_type const* const> init_list)
+   {
+       basic_parser::add_params(init_list);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::add_params(std::initializer_list<char_type const* const> init_list)
+   {
+      for (auto& name : init_list)
+         registeredParams_.emplace(trim_leading_dashes(slice_type(name)));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline key basic_parser<String, Storage>::add_params(std::initializer_list<char_type const* const> aliases, slice_type const& canonical)
+   {
+      auto const canonical_name = trim_leading_dashes(canonical);
+      for (auto& name : aliases)
+      {
+         auto const trimmed_name = trim_leading_dashes(slice_type(name));
+         registeredParams_.emplace(trimmed_name);
+         if (trimmed_name != canonical_name)
+            add_alias(trimmed_name, canonical_name);
+      }
+      return add_param(canonical_name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline key basic_parser<String, Storage>::add_flags(std::initializer_list<char_type const* const> aliases, slice_type const& canonical)
+   {
+      auto const canonical_name = trim_leading_dashes(canonical);
+      for (auto& name : aliases)
+      {
+         auto const trimmed_name = trim_leading_dashes(slice_type(name));
+         registeredFlags_.emplace(trimmed_name);
+         if (trimmed_name != canonical_name)
+            add_alias(trimmed_name, canonical_name);
+      }
+      return add_flag(canonical_name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline key basic_parser<String, Storage>::add_params(const slice_type &name)
+   {
+       return basic_parser::add_param(name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::add_subcommand(slice_type const& name)
+   {
+      registeredSubcommands_.emplace(name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline void basic_parser<String, Storage>::add_subcommands(std::initializer_list<char_type const* const> init_list)
+   {
+      for (auto& name : init_list)
+         registeredSubcommands_.emplace(slice_type(name));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::args_range basic_parser<String, Storage>::remainder() const
+   {
+      return args_range(args_.begin() + static_cast<std::ptrdiff_t>(remainder_first_), args_.begin() + static_cast<std::ptrdiff_t>(remainder_last_));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline std::string basic_parser<String, Storage>::serialize() const
+   {
+      static_assert(std::is_same<char_type, char>::value, "only parsers of char can be serialized");
+      using format = detail::frozen_format;
+
+      auto const& flags = this->flags();
+      detail::frozen_writer writer;
+      writer.set_count(format::flag_count, flags.size());
+      writer.set_count(format::param_count, params_.size());
+      writer.set_count(format::pos_arg_count, pos_args_.size());
+      writer.set_count(format::remainder_count, remainder_last_ - remainder_first_);
+      writer.set_count(format::fallback_count, fallback_.size());
+
+      for (auto const& flag : flags)
+         writer.add_name(flag.data(), flag.size());
+      for (auto const& param : params_)
+      {
+         writer.add_name(param.first.data(), param.first.size());
+         writer.add(param.second.data(), param.second.size());
+      }
+      for (auto const& arg : pos_args_)
+         writer.add(arg.data(), arg.size());
+      for (auto const& arg : remainder())
+         writer.add(arg.data(), arg.size());
+      for (auto const& entry : fallback_)
+      {
+         writer.add(entry.name, entry.name_size);
+         writer.add(entry.value, entry.value_size);
+      }
+      return writer.blob();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline typename basic_parser<String, Storage>::params_range basic_parser<String, Storage>::params(string_type const& name) const
+   {
+      string_type storage;
+      auto const& canonical_name = canonical(lookup_name(name, storage));
+      return params_range(params_.lower_bound(canonical_name), params_.upper_bound(canonical_name));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Incremental parsing: args arriving in chunks, e.g. from a pipe or a socket, are parsed as they come.
+
+   // Parses args into a parser as they are fed: each arg ends with a '\0' (as in /proc/<pid>/cmdline, or the output
+   // of find -print0), and a chunk may end anywhere. An arg is parsed, with the rules of parser::parse(), as soon as
+   // the next one is known; finish() then only handles the last one. EXPAND_RESPONSE_FILES is not supported here.
+   class incremental_parser
+   {
+   public:
+      explicit incremental_parser(int mode = parser_base::PREFER_FLAG_FOR_UNREG_OPTION)
+         : sink_{ parser_ }, scanner_(mode, sink_)
+      {
+         parser_.prefix_matching_ = 0 != (mode & parser_base::MATCH_UNIQUE_PREFIX);
+      }
+
+      incremental_parser(incremental_parser const&) = delete;
+      incremental_parser& operator=(incremental_parser const&) = delete;
+
+      // the parser the args are parsed into: register its params, flags and subcommands before the first feed()
+      parser& target() { return parser_; }
+
+      void feed(char const* data, size_t size);
+
+      // parses the last arg, if it was not terminated, and returns the parser
+      parser& finish();
+
+   private:
+      void push_arg();
+
+      parser parser_;
+      parser::arg_sink sink_;
+      detail::arg_scanner<parser::slice_type, std::string, parser::arg_sink> scanner_;
+      std::string args_[2]; // the arg being fed, and the one before, pending in the scanner
+      int current_ = 0;
+      bool finished_ = false;
+   };
+
+   //////////////////////////////////////////////////////////////////////////
+
+   inline void incremental_parser::feed(char const* data, size_t size)
+   {
+      for (auto const end = data + size; data != end; )
+      {
+         auto const nul = static_cast<char const*>(std::memchr(data, '\0', static_cast<size_t>(end - data)));
+         args_[current_].append(data, nul ? nul : end);
+         if (!nul)
+            break;
+         push_arg();
+         data = nul + 1;
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   inline void incremental_parser::push_arg()
+   {
+      auto& arg = args_[current_];
+      if (!scanner_.stopped())
+      {
+         if (scanner_.push(arg))
+         {
+            current_ ^= 1;
+            args_[current_].clear();
+            return;
+         }
+         // stopped at the pending arg: a subcommand is left in the remainder, a "--" is not
+         if (scanner_.remainder_first() + 2 == scanner_.size())
+            parser_.args_.push_back(args_[current_ ^ 1]);
+      }
+      parser_.args_.push_back(arg);
+      arg.clear();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   inline parser& incremental_parser::finish()
+   {
+      if (finished_)
+         return parser_;
+      finished_ = true;
+
+      if (!args_[current_].empty())
+         push_arg();
+      if (!scanner_.stopped() && scanner_.finish() < scanner_.size())
+         parser_.args_.push_back(args_[current_ ^ 1]); // the last arg is a subcommand
+      parser_.remainder_first_ = 0;
+      parser_.end_parse(parser_.args_.size());
+      return parser_;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Overlays: variants of one parse, e.g. per job, that override a few of its params and flags.
+
+   namespace detail
+   {
+      // a range of the iterators of a view, e.g. the params of an overlay
+      template<typename It>
+      class iterator_range
+      {
+      public:
+         iterator_range(It first, It last) : first_(first), last_(last) {}
+
+         It begin() const { return first_; }
+         It end() const { return last_; }
+         bool empty() const { return first_ == last_; }
+         size_t size() const { return static_cast<size_t>(std::distance(first_, last_)); }
+
+      private:
+         It first_;
+         It last_;
+      };
+
+      // the operator->() of an iterator whose reference is a value, e.g. a pair of references
+      template<typename Reference>
+      struct arrow_proxy
+      {
+         Reference value;
+         Reference const* operator->() const { return &value; }
+      };
+   }
+
+   // A parse seen through a few changes: params set (replacing all the values of the name in the base), flags set or
+   // cleared, and positional args appended after those of the base. Lookups check the changes first, then the base,
+   // which is shared and never modified: an overlay costs only its changes, and the const accessors of the base can be
+   // used from many threads at once (see freeze()). Names are canonicalized by the base, so its aliases
+   // apply. An overlay of a view_parser refers to the names and values it is given, which must outlive it.
+   template<typename Parser>
+   class basic_overlay
+   {
+   public:
+      using string_type = typename Parser::string_type;
+      using char_type = typename Parser::char_type;
+      using stream_type = typename Parser::stream_type;
+
+   private:
+      template<typename Value>
+      using changes = std::vector<std::pair<string_type, Value>>; // sorted by canonical name
+
+   public:
+
+      class param_iterator;
+      class flag_iterator;
+      class pos_arg_iterator;
+      using params_range = detail::iterator_range<param_iterator>;
+      using flags_range = detail::iterator_range<flag_iterator>;
+      using pos_args_range = detail::iterator_range<pos_arg_iterator>;
+
+      explicit basic_overlay(Parser const& base) : base_(&base) {}
+
+      Parser const& base() const { return *base_; }
+
+      void set_param(string_type const& name, string_type const& value);
+      void set_flag(string_type const& name, bool value = true);
+      void add_pos_arg(string_type const& value);
+
+      // the parse as changed, sorted like the containers of Parser: the params of the base and the changed ones
+      // (a changed name has only its new value), the flags of the base not cleared and the ones set, and the
+      // positional args of the base followed by the added ones. Reading them calls flags() of the base.
+      params_range   params()                        const;
+      params_range   params(string_type const& name) const;
+      flags_range    flags()                         const;
+      pos_args_range pos_args()                      const { return pos_args_range(begin(), end()); }
+
+      pos_arg_iterator begin() const { return pos_arg_iterator(this, 0); }
+      pos_arg_iterator end()   const { return pos_arg_iterator(this, size()); }
+      size_t size()            const { return base_->size() + pos_args_.size(); }
+
+      // the accessors of Parser, over the changes and the base
+      bool operator[](string_type const& name) const;
+      bool operator[](std::initializer_list<char_type const* const> init_list) const;
+      bool operator[](key k) const;
+      string_type const& operator[](size_t ind) const;
+      stream_type operator()(string_type const& name) const;
+      stream_type operator()(std::initializer_list<char_type const* const> init_list) const;
+      stream_type operator()(key k) const;
+      stream_type operator()(size_t ind) const;
+      template<typename T>
+      stream_type operator()(string_type const& name, T&& def_val) const;
+      template<typename T>
+      stream_type operator()(std::initializer_list<char_type const* const> init_list, T&& def_val) const;
+      template<typename T>
+      stream_type operator()(key k, T&& def_val) const;
+      template<typename T>
+      stream_type operator()(size_t ind, T&& def_val) const;
+      template<typename T>
+      result<T> get(string_type const& name) const;
+      template<typename T>
+      result<T> get(std::initializer_list<char_type const* const> init_list) const;
+      template<typename T>
+      result<T> get(key k) const;
+      template<typename T>
+      result<T> get(size_t ind) const;
+      template<typename T, typename Alloc>
+      get_status get_list(string_type const& name, std::vector<T, Alloc>& out, char_type sep = ',') const;
+      template<typename T>
+      result<std::vector<T>> get_list(string_type const& name, char_type sep = ',') const;
+      template<typename T>
+      T value_or(string_type const& name, T def_val) const;
+      template<typename T>
+      T value_or(std::initializer_list<char_type const* const> init_list, T def_val) const;
+      template<typename T>
+      T value_or(key k, T def_val) const;
+      template<typename T>
+      T value_or(size_t ind, T def_val) const;
+      string_type value_or(string_type const& name, char_type const* def_val) const;
+      string_type value_or(std::initializer_list<char_type const* const> init_list, char_type const* def_val) const;
+      string_type value_or(key k, char_type const* def_val) const;
+      string_type value_or(size_t ind, char_type const* def_val) const;
+
+      // the param iterator yields pairs of references to the name and value
+      class param_iterator
+      {
+      public:
+         using iterator_category = std::input_iterator_tag;
+         using value_type = std::pair<string_type, string_type>;
+         using reference = std::pair<string_type const&, string_type const&>;
+         using pointer = detail::arrow_proxy<reference>;
+         using difference_type = std::ptrdiff_t;
+
+         reference operator*() const { return from_base() ? reference(base_->first, base_->second) : reference(change_->first, change_->second); }
+         pointer operator->() const { return pointer{ **this }; }
+         param_iterator& operator++();
+         param_iterator operator++(int) { auto it = *this; ++*this; return it; }
+         bool operator==(param_iterator const& other) const { return base_ == other.base_ && change_ == other.change_; }
+         bool operator!=(param_iterator const& other) const { return !(*this == other); }
+
+      private:
+         friend class basic_overlay;
+         using base_iterator = typename Parser::params_container::const_iterator;
+         using change_iterator = typename changes<string_type>::const_iterator;
+
+         param_iterator(base_iterator base, base_iterator base_last, change_iterator change, basic_overlay const* overlay);
+         bool from_base() const { return base_last_ != base_ && (overlay_->params_.end() == change_ || base_->first < change_->first); }
+         void skip_changed();
+
+         base_iterator base_;
+         base_iterator base_last_;
+         change_iterator change_;
+         basic_overlay const* overlay_;
+      };
+
+      class flag_iterator
+      {
+      public:
+         using iterator_category = std::forward_iterator_tag;
+         using value_type = string_type;
+         using reference = string_type const&;
+         using pointer = string_type const*;
+         using difference_type = std::ptrdiff_t;
+
+         reference operator*() const { return from_base() ? *base_ : change_->first; }
+         pointer operator->() const { return &**this; }
+         flag_iterator& operator++();
+         flag_iterator operator++(int) { auto it = *this; ++*this; return it; }
+         bool operator==(flag_iterator const& other) const { return base_ == other.base_ && change_ == other.change_; }
+         bool operator!=(flag_iterator const& other) const { return !(*this == other); }
+
+      private:
+         friend class basic_overlay;
+         using base_iterator = typename Parser::flags_container::const_iterator;
+         using change_iterator = typename changes<bool>::const_iterator;
+
+         flag_iterator(base_iterator base, base_iterator base_last, change_iterator change, basic_overlay const* overlay);
+         bool from_base() const { return base_last_ != base_ && (overlay_->flags_.end() == change_ || *base_ < change_->first); }
+         void skip_changed();
+
+         base_iterator base_;
+         base_iterator base_last_;
+         change_iterator change_;
+         basic_overlay const* overlay_;
+      };
+
+      class pos_arg_iterator
+      {
+      public:
+         using iterator_category = std::forward_iterator_tag;
+         using value_type = string_type;
+         using reference = string_type const&;
+         using pointer = string_type const*;
+         using difference_type = std::ptrdiff_t;
+
+         reference operator*() const { return (*overlay_)[ind_]; }
+         pointer operator->() const { return &**this; }
+         pos_arg_iterator& operator++() { ++ind_; return *this; }
+         pos_arg_iterator operator++(int) { auto it = *this; ++ind_; return it; }
+         bool operator==(pos_arg_iterator const& other) const { return ind_ == other.ind_; }
+         bool operator!=(pos_arg_iterator const& other) const { return ind_ != other.ind_; }
+
+      private:
+         friend class basic_overlay;
+         pos_arg_iterator(basic_overlay const* overlay, size_t ind) : overlay_(overlay), ind_(ind) {}
+
+         basic_overlay const* overlay_;
+         size_t ind_;
+      };
+
+   private:
+      template<typename Value>
+      static typename changes<Value>::const_iterator find_change(changes<Value> const& list, string_type const& name);
+      template<typename Value>
+      static Value const* find(changes<Value> const& list, string_type const& name);
+      template<typename Value>
+      static void set(changes<Value>& list, string_type const& name, Value const& value);
+      template<typename Name>
+      bool got_flag(Name const& name) const;
+      template<typename Name>
+      typename Parser::param_value find_param(Name const& name) const;
+      typename Parser::param_value find_value(key k) const;
+      string_type const* find_pos_arg(size_t ind) const;
+      static typename Parser::param_value param_value(string_type const* value);
+      template<typename T>
+      static stream_type default_stream(T const& def_val);
+
+      Parser const* base_;
+      changes<string_type> params_;
+      changes<bool> flags_;
+      std::vector<string_type> pos_args_;
+   };
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename String, typename Storage>
+   inline basic_overlay<basic_parser<String, Storage>> basic_parser<String, Storage>::overlay() const
+   {
+      return basic_overlay<basic_parser>(*this);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename Value>
+   inline typename basic_overlay<Parser>::template changes<Value>::const_iterator basic_overlay<Parser>::find_change(changes<Value> const& list, string_type const& name)
+   {
+      auto const it = std::lower_bound(list.begin(), list.end(), name,
+         [](std::pair<string_type, Value> const& change, string_type const& n) { return change.first < n; });
+      return list.end() != it && it->first == name ? it : list.end();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename Value>
+   inline Value const* basic_overlay<Parser>::find(changes<Value> const& list, string_type const& name)
+   {
+      auto const it = find_change(list, name);
+      return list.end() != it ? &it->second : nullptr;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename Value>
+   inline void basic_overlay<Parser>::set(changes<Value>& list, string_type const& name, Value const& value)
+   {
+      auto const it = std::lower_bound(list.begin(), list.end(), name,
+         [](std::pair<string_type, Value> const& change, string_type const& n) { return change.first < n; });
+      if (list.end() != it && it->first == name)
+         it->second = value;
+      else
+         list.emplace(it, name, value);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline void basic_overlay<Parser>::set_param(string_type const& name, string_type const& value)
+   {
+      string_type storage;
+      set(params_, base_->canonical(Parser::lookup_name(name, storage)), value);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline void basic_overlay<Parser>::set_flag(string_type const& name, bool value /*= true*/)
+   {
+      string_type storage;
+      set(flags_, base_->canonical(Parser::lookup_name(name, storage)), value);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline void basic_overlay<Parser>::add_pos_arg(string_type const& value)
+   {
+      pos_args_.push_back(value);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename Name>
+   inline bool basic_overlay<Parser>::got_flag(Name const& name) const
+   {
+      if (!flags_.empty())
+      {
+         string_type const& typed_name = name;
+         string_type storage;
+         if (auto const value = find(flags_, base_->canonical(Parser::lookup_name(typed_name, storage))))
+            return *value;
+      }
+      return base_->got_flag(name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename Name>
+   inline typename Parser::param_value basic_overlay<Parser>::find_param(Name const& name) const
+   {
+      if (!params_.empty())
+      {
+         string_type const& typed_name = name;
+         string_type storage;
+         if (auto const value = find(params_, base_->canonical(Parser::lookup_name(typed_name, storage))))
+            return param_value(value);
+      }
+      return base_->find_param(name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename Parser::param_value basic_overlay<Parser>::find_value(key k) const
+   {
+      if (!params_.empty())
+      {
+         if (auto const name = base_->key_name(k))
+         {
+            string_type const& typed_name = *name;
+            if (auto const value = find(params_, base_->canonical(typed_name)))
+               return param_value(value);
+         }
+      }
+      return base_->find_value(k);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::string_type const* basic_overlay<Parser>::find_pos_arg(size_t ind) const
+   {
+      return base_->size() <= ind && ind - base_->size() < pos_args_.size() ? &pos_args_[ind - base_->size()] : nullptr;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename Parser::param_value basic_overlay<Parser>::param_value(string_type const* value)
+   {
+      typename Parser::param_value found;
+      found.arg = value;
+      return found;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   inline typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::default_stream(T const& def_val)
+   {
+      std::basic_ostringstream<char_type, typename Parser::traits_type> ostr;
+      ostr.precision(std::numeric_limits<long double>::max_digits10);
+      ostr << def_val;
+      return stream_type(ostr.str());
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::params_range basic_overlay<Parser>::params() const
+   {
+      auto const& base = base_->params();
+      return params_range(param_iterator(base.begin(), base.end(), params_.begin(), this),
+                          param_iterator(base.end(), base.end(), params_.end(), this));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::params_range basic_overlay<Parser>::params(string_type const& name) const
+   {
+      auto const base = base_->params(name);
+      string_type storage;
+      auto const change = params_.empty() ? params_.end() : find_change(params_, base_->canonical(Parser::lookup_name(name, storage)));
+      if (params_.end() == change)
+         return params_range(param_iterator(base.begin(), base.end(), params_.end(), this),
+                             param_iterator(base.end(), base.end(), params_.end(), this));
+      return params_range(param_iterator(base.end(), base.end(), change, this),
+                          param_iterator(base.end(), base.end(), change + 1, this));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::flags_range basic_overlay<Parser>::flags() const
+   {
+      auto const& base = base_->flags();
+      return flags_range(flag_iterator(base.begin(), base.end(), flags_.begin(), this),
+                         flag_iterator(base.end(), base.end(), flags_.end(), this));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline basic_overlay<Parser>::param_iterator::param_iterator(base_iterator base, base_iterator base_last, change_iterator change, basic_overlay const* overlay)
+      : base_(base)
+      , base_last_(base_last)
+      , change_(change)
+      , overlay_(overlay)
+   {
+      skip_changed();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::param_iterator& basic_overlay<Parser>::param_iterator::operator++()
+   {
+      if (from_base())
+         ++base_;
+      else
+         ++change_;
+      skip_changed();
+      return *this;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // skips the values of the base replaced by a change
+   template<typename Parser>
+   inline void basic_overlay<Parser>::param_iterator::skip_changed()
+   {
+      while (base_last_ != base_ && find(overlay_->params_, base_->first))
+         ++base_;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline basic_overlay<Parser>::flag_iterator::flag_iterator(base_iterator base, base_iterator base_last, change_iterator change, basic_overlay const* overlay)
+      : base_(base)
+      , base_last_(base_last)
+      , change_(change)
+      , overlay_(overlay)
+   {
+      skip_changed();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::flag_iterator& basic_overlay<Parser>::flag_iterator::operator++()
+   {
+      if (from_base())
+         ++base_;
+      else
+         ++change_;
+      skip_changed();
+      return *this;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   // skips the flags of the base that are changed, and the changes that clear a flag
+   template<typename Parser>
+   inline void basic_overlay<Parser>::flag_iterator::skip_changed()
+   {
+      for (;;)
+      {
+         if (base_last_ != base_ && find(overlay_->flags_, *base_))
+            ++base_;
+         else if (overlay_->flags_.end() != change_ && !change_->second)
+            ++change_;
+         else
+            break;
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline bool basic_overlay<Parser>::operator[](string_type const& name) const
+   {
+      return got_flag(name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline bool basic_overlay<Parser>::operator[](std::initializer_list<char_type const* const> init_list) const
+   {
+      return std::any_of(init_list.begin(), init_list.end(), [&](char_type const* const name) { return got_flag(name); });
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline bool basic_overlay<Parser>::operator[](key k) const
+   {
+      if (!flags_.empty())
+      {
+         if (auto const name = base_->key_name(k))
+         {
+            string_type const& typed_name = *name;
+            if (auto const value = find(flags_, base_->canonical(typed_name)))
+               return *value;
+         }
+      }
+      return (*base_)[k];
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::string_type const& basic_overlay<Parser>::operator[](size_t ind) const
+   {
+      auto const value = find_pos_arg(ind);
+      return value ? *value : (*base_)[ind];
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::operator()(string_type const& name) const
+   {
+      auto const value = find_param(name);
+      return value ? Parser::make_stream(value) : base_->bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::operator()(std::initializer_list<char_type const* const> init_list) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return Parser::make_stream(value);
+      }
+      return base_->bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::operator()(key k) const
+   {
+      auto const value = find_value(k);
+      return value ? Parser::make_stream(value) : base_->bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::operator()(size_t ind) const
+   {
+      auto const value = find_pos_arg(ind);
+      return value ? Parser::make_stream(param_value(value)) : (*base_)(ind);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::operator()(string_type const& name, T&& def_val) const
+   {
+      auto const value = find_param(name);
+      return value ? Parser::make_stream(value) : default_stream(def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::operator()(std::initializer_list<char_type const* const> init_list, T&& def_val) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return Parser::make_stream(value);
+      }
+      return default_stream(def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::operator()(key k, T&& def_val) const
+   {
+      auto const value = find_value(k);
+      return value ? Parser::make_stream(value) : default_stream(def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   typename basic_overlay<Parser>::stream_type basic_overlay<Parser>::operator()(size_t ind, T&& def_val) const
+   {
+      auto const value = find_pos_arg(ind);
+      return value ? Parser::make_stream(param_value(value)) : (*base_)(ind, std::forward<T>(def_val));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   result<T> basic_overlay<Parser>::get(string_type const& name) const
+   {
+      auto const value = find_param(name);
+      return value ? Parser::template convert<T>(value) : get_status::MISSING;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   result<T> basic_overlay<Parser>::get(std::initializer_list<char_type const* const> init_list) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return Parser::template convert<T>(value);
+      }
+      return get_status::MISSING;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   result<T> basic_overlay<Parser>::get(key k) const
+   {
+      auto const value = find_value(k);
+      return value ? Parser::template convert<T>(value) : get_status::MISSING;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   result<T> basic_overlay<Parser>::get(size_t ind) const
+   {
+      auto const value = find_pos_arg(ind);
+      return value ? Parser::template convert<T>(*value) : base_->template get<T>(ind);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T, typename Alloc>
+   get_status basic_overlay<Parser>::get_list(string_type const& name, std::vector<T, Alloc>& out, char_type sep /*= ','*/) const
+   {
+      return Parser::split_list(params(name), out, sep);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   result<std::vector<T>> basic_overlay<Parser>::get_list(string_type const& name, char_type sep /*= ','*/) const
+   {
+      std::vector<T> values;
+      auto const status = get_list(name, values, sep);
+      if (get_status::OK != status)
+         return status;
+      return result<std::vector<T>>(std::move(values));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   T basic_overlay<Parser>::value_or(string_type const& name, T def_val) const
+   {
+      auto const value = find_param(name);
+      return value ? Parser::convert_or(value.first(), value.last(), def_val) : def_val;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   T basic_overlay<Parser>::value_or(std::initializer_list<char_type const* const> init_list, T def_val) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return Parser::convert_or(value.first(), value.last(), def_val);
+      }
+      return def_val;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   T basic_overlay<Parser>::value_or(key k, T def_val) const
+   {
+      auto const value = find_value(k);
+      return value ? Parser::convert_or(value.first(), value.last(), def_val) : def_val;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   template<typename T>
+   T basic_overlay<Parser>::value_or(size_t ind, T def_val) const
+   {
+      auto const value = find_pos_arg(ind);
+      return value ? Parser::convert_or(value->data(), value->data() + value->size(), def_val) : base_->value_or(ind, def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::string_type basic_overlay<Parser>::value_or(string_type const& name, char_type const* def_val) const
+   {
+      return Parser::string_or(find_param(name), def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::string_type basic_overlay<Parser>::value_or(std::initializer_list<char_type const* const> init_list, char_type const* def_val) const
+   {
+      for (auto& name : init_list)
+      {
+         if (auto const value = find_param(name))
+            return Parser::string_or(value, def_val);
+      }
+      return string_type(def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::string_type basic_overlay<Parser>::value_or(key k, char_type const* def_val) const
+   {
+      return Parser::string_or(find_value(k), def_val);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Parser>
+   inline typename basic_overlay<Parser>::string_type basic_overlay<Parser>::value_or(size_t ind, char_type const* def_val) const
+   {
+      auto const value = find_pos_arg(ind);
+      return value ? *value : base_->value_or(ind, def_val);
+   }
+
+#if defined(ARGH_HAS_STRING_VIEW)
+   //////////////////////////////////////////////////////////////////////////
+   // Compile-time schemas: programs with a fixed set of options can declare them in a type
+   //
+   //    struct my_schema
+   //    {
+   //       static constexpr argh::static_option options[] = {
+   //          argh::static_param("o", "output"),
+   //          argh::static_flag("v", "verbose"),
+   //       };
+   //    };
+   //
+   // and parse with argh::static_parser<my_schema>. The names of an option are aliases of each other.
+   // They are looked up in a perfect hash table built at compile time: no string is constructed or compared
+   // more than once per lookup, and a name missing from the schema can be rejected at compile time (see static_key).
+
+   struct static_option
+   {
+      enum kind_type { flag, param };
+      static constexpr size_t max_names = 4;
+
+      kind_type kind;
+      std::string_view names[max_names];
+   };
+
+   namespace detail
+   {
+      constexpr std::string_view trim_leading_dashes_constexpr(std::string_view name)
+      {
+         auto pos = name.find_first_not_of('-');
+         return std::string_view::npos != pos ? name.substr(pos) : name;
+      }
+
+      template<typename... Names>
+      constexpr static_option make_static_option(static_option::kind_type kind, Names... names)
+      {
+         static_assert(0 < sizeof...(Names) && sizeof...(Names) <= static_option::max_names, "an option has 1 to 4 names");
+         return static_option{ kind, { trim_leading_dashes_constexpr(std::string_view(names))... } };
+      }
+   }
+
+   template<typename... Names>
+   constexpr static_option static_flag(Names... names) { return detail::make_static_option(static_option::flag, names...); }
+
+   template<typename... Names>
+   constexpr static_option static_param(Names... names) { return detail::make_static_option(static_option::param, names...); }
+
+   namespace detail
+   {
+      // FNV-1a
+      constexpr std::uint64_t static_hash(std::string_view name)
+      {
+         std::uint64_t h = 14695981039346656037ull;
+         for (char c : name)
+         {
+            h ^= static_cast<unsigned char>(c);
+            h *= 1099511628211ull;
+         }
+         return h;
+      }
+
+      // rehashes a name hash with a bucket displacement (splitmix64 finalizer)
+      constexpr std::uint64_t static_rehash(std::uint64_t h, std::uint64_t displacement)
+      {
+         h ^= displacement * 0x9E3779B97F4A7C15ull;
+         h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+         h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+         return h ^ (h >> 31);
+      }
+
+      constexpr size_t static_pow2_at_least(size_t n)
+      {
+         size_t p = 1;
+         while (p < n)
+            p *= 2;
+         return p;
+      }
+
+      template<size_t N>
+      constexpr size_t static_name_count(static_option const (&options)[N])
+      {
+         size_t count = 0;
+         for (auto& option : options)
+            for (auto& name : option.names)
+               count += !name.empty();
+         return count;
+      }
+
+      template<size_t Buckets, size_t Slots>
+      struct static_table
+      {
+         struct slot
+         {
+            std::string_view name;
+            size_t option = static_cast<size_t>(-1);
+         };
+
+         std::uint32_t displacements[Buckets] = {};
+         slot slots[Slots] = {};
+
+         constexpr size_t find(std::string_view name) const
+         {
+            auto const h = static_hash(name);
+            auto const& s = slots[static_rehash(h, displacements[h & (Buckets - 1)]) & (Slots - 1)];
+            return s.name == name ? s.option : static_cast<size_t>(-1);
+         }
+      };
+
+      // Hash and displace: the names are spread over Buckets buckets by their hash, then for each bucket,
+      // largest first, a displacement is searched that rehashes all its names to free slots.
+      // With twice as many slots as names, a few tries per bucket are usually enough. The names are grouped
+      // by bucket first, so that each try only looks at the names of its bucket: a schema of hundreds of
+      // options stays well within the operation limits of constant evaluation.
+      template<size_t Buckets, size_t Slots, size_t N>
+      constexpr static_table<Buckets, Slots> build_static_table(static_option const (&options)[N])
+      {
+         constexpr size_t npos = static_cast<size_t>(-1);
+         struct entry
+         {
+            std::string_view name;
+            size_t option = npos;
+            std::uint64_t hash = 0;
+         };
+
+         // counting sort by bucket: the entries of bucket b are [bucket_first[b], bucket_first[b + 1])
+         size_t bucket_first[Buckets + 1] = {};
+         for (auto& option : options)
+            for (auto& name : option.names)
+               if (!name.empty())
+                  ++bucket_first[(static_hash(name) & (Buckets - 1)) + 1];
+         for (size_t b = 0; b < Buckets; ++b)
+            bucket_first[b + 1] += bucket_first[b];
+
+         entry entries[Slots] = {};
+         size_t next[Buckets] = {};
+         for (size_t b = 0; b < Buckets; ++b)
+            next[b] = bucket_first[b];
+         for (size_t o = 0; o < N; ++o)
+            for (auto& name : options[o].names)
+               if (!name.empty())
+               {
+                  auto const hash = static_hash(name);
+                  entries[next[hash & (Buckets - 1)]++] = entry{ name, o, hash };
+               }
+
+         // equal names, or equal hashes, are in the same bucket
+         size_t largest = 0;
+         for (size_t b = 0; b < Buckets; ++b)
+         {
+            for (size_t i = bucket_first[b]; i < bucket_first[b + 1]; ++i)
+               for (size_t j = i + 1; j < bucket_first[b + 1]; ++j)
+               {
+                  if (entries[i].name == entries[j].name)
+                     throw std::logic_error("argh: the same name appears twice in a static_parser schema");
+                  if (entries[i].hash == entries[j].hash)
+                     throw std::logic_error("argh: two names of a static_parser schema have the same hash");
+               }
+            if (largest < bucket_first[b + 1] - bucket_first[b])
+               largest = bucket_first[b + 1] - bucket_first[b];
+         }
+
+         static_table<Buckets, Slots> table;
+         size_t taken[Slots] = {}; // the slots of the bucket being placed
+         for (size_t size = largest; 0 < size; --size)
+            for (size_t b = 0; b < Buckets; ++b)
+            {
+               auto const first = bucket_first[b];
+               auto const last = bucket_first[b + 1];
+               if (last - first != size)
+                  continue;
+
+               for (std::uint32_t d = 0;; ++d)
+               {
+                  if (Slots * 1024 < d)
+                     throw std::logic_error("argh: no perfect hash found for the static_parser schema");
+
+                  bool fits = true;
+                  for (size_t i = first; fits && i < last; ++i)
+                  {
+                     auto const s = static_rehash(entries[i].hash, d) & (Slots - 1);
+                     fits = npos == table.slots[s].option;
+                     for (size_t t = first; fits && t < i; ++t)
+                        fits = taken[t - first] != s;
+                     taken[i - first] = s;
+                  }
+                  if (!fits)
+                     continue;
+
+                  table.displacements[b] = d;
+                  for (size_t i = first; i < last; ++i)
+                  {
+                     auto& s = table.slots[taken[i - first]];
+                     s.name = entries[i].name;
+                     s.option = entries[i].option;
+                  }
+                  break;
+               }
+            }
+         return table;
+      }
+
+      template<typename Schema>
+      struct static_index
+      {
+         static constexpr size_t npos = static_cast<size_t>(-1);
+         static constexpr size_t option_count = std::extent<decltype(Schema::options)>::value;
+         static constexpr size_t name_count = static_name_count(Schema::options);
+         static constexpr size_t bucket_count = static_pow2_at_least((name_count + 1) / 2);
+         static constexpr size_t slot_count = static_pow2_at_least(2 * name_count);
+         static constexpr auto table = build_static_table<bucket_count, slot_count>(Schema::options);
+
+         static_assert(0 < name_count, "a static_parser schema needs at least one option");
+
+         // index of the option named name, or npos
+         static constexpr size_t find(std::string_view name) { return table.find(trim_leading_dashes_constexpr(name)); }
+
+         static constexpr bool is_kind(std::string_view name, static_option::kind_type kind)
+         {
+            auto const option = table.find(name);
+            return npos != option && kind == Schema::options[option].kind;
+         }
+      };
+   }
+
+   // The option of a static_parser schema named name (or any of its aliases).
+   // The name is checked against the schema when the key is constructed: declare keys constexpr,
+   // and a misspelled name fails to compile instead of silently never matching.
+   //    constexpr argh::static_key<my_schema> output("output");
+   template<typename Schema>
+   class static_key
+   {
+   public:
+      constexpr explicit static_key(std::string_view name)
+         : index_(detail::static_index<Schema>::find(name))
+      {
+         if (detail::static_index<Schema>::npos == index_)
+            throw std::invalid_argument("argh: the name is not in the static_parser schema");
+      }
+
+      constexpr size_t index() const { return index_; }
+
+   private:
+      size_t index_;
+   };
+
+   // A parser for the options of Schema, see static_option above.
+   // Like view_parser, it refers back into the parsed argv, which must outlive it.
+   // Options missing from the schema are parsed as with basic_parser, following the mode,
+   // and are kept aside in unknown_flags() and unknown_params(). The flags of the schema never take a value,
+   // even with PREFER_PARAM_FOR_UNREG_OPTION.
+   template<typename Schema>
+   class static_parser : public parser_base
+   {
+      using index = detail::static_index<Schema>;
+
+   public:
+      using key = static_key<Schema>;
+      using string_type = std::string_view;
+      using pos_args_container = std::vector<std::string_view>;
+      using unknown_params_container = std::vector<std::pair<std::string_view, std::string_view>>;
+      using args_range = basic_multimap_iteration_wrapper<std::vector<std::string_view>>;
+
+      static constexpr size_t option_count = index::option_count;
+
+      static_parser() = default;
+
+      static_parser(const char* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION)
+      {  parse(argv, mode); }
+
+      static_parser(int argc, const char* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION)
+      {  parse(argc, argv, mode); }
+
+      // the containers keep their capacity: re-parsing similar command lines does not allocate
+      void parse(const char* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+      void parse(int argc, const char* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+
+      pos_args_container       const& pos_args()       const { return pos_args_;       }
+      pos_args_container       const& unknown_flags()  const { return unknown_flags_;  }
+      unknown_params_container const& unknown_params() const { return unknown_params_; }
+
+      // the args after "--" in DOUBLE_DASH_ENDS_OPTIONS mode, left unparsed
+      args_range remainder() const { return args_range(args_.begin() + static_cast<std::ptrdiff_t>(remainder_first_), args_.end()); }
+
+      typename pos_args_container::const_iterator begin() const { return pos_args_.cbegin(); }
+      typename pos_args_container::const_iterator end()   const { return pos_args_.cend();   }
+      size_t size()                                       const { return pos_args_.size();   }
+
+      //////////////////////////////////////////////////////////////////////////
+      // Accessors. The std::string_view overloads look the name up at run time, also in constant time;
+      // names missing from the schema are never found there.
+
+      // flag accessors: return true if the option appeared as a flag, otherwise false.
+      bool operator[](key k) const                  { return options_[k.index()].flag; }
+      bool operator[](std::string_view name) const;
+
+      // returns positional arg string by order. Like argv[] but without the options
+      std::string_view operator[](size_t ind) const { return ind < pos_args_.size() ? pos_args_[ind] : std::string_view(); }
+
+      // parameter accessors, give a key or a name get an std::istream that can be used to convert to a typed value.
+      // for a param given more than once, the first value is returned.
+      string_stream operator()(key k) const;
+      string_stream operator()(std::string_view name) const;
+
+      // returns a std::istream that can be used to convert a positional arg to a typed value.
+      string_stream operator()(size_t ind) const;
+
+      // typed accessors, same conversions as basic_parser::get<T>()
+      template<typename T>
+      result<T> get(key k) const;
+
+      template<typename T>
+      result<T> get(std::string_view name) const;
+
+      template<typename T>
+      result<T> get(size_t ind) const;
+
+   private:
+      struct option_state
+      {
+         bool flag = false;
+         bool has_value = false;
+         std::string_view value;
+      };
+
+      struct arg_sink
+      {
+         static_parser& parser;
+         bool is_param(std::string_view name) const { return index::is_kind(name, static_option::param); }
+         bool is_flag(std::string_view name) const  { return index::is_kind(name, static_option::flag); }
+         bool is_subcommand(std::string_view) const { return false; }
+         void flag(std::string_view name);
+         void param(std::string_view name, std::string_view value);
+         void positional(std::string_view arg)      { parser.pos_args_.push_back(arg); }
+      };
+
+      option_state const* find(std::string_view name) const;
+      static string_stream bad_stream();
+      template<typename T>
+      static result<T> convert(option_state const* option);
+      template<typename T>
+      static result<T> convert(std::string_view arg);
+
+      std::vector<std::string_view> args_;
+      size_t remainder_first_ = 0;
+      option_state options_[option_count];
+      pos_args_container pos_args_;
+      pos_args_container unknown_flags_;
+      unknown_params_container unknown_params_;
+   };
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline void static_parser<Schema>::parse(const char* const argv[], int mode)
+   {
+      int argc = 0;
+      for (auto argvp = argv; *argvp; ++argc, ++argvp);
+      parse(argc, argv, mode);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline void static_parser<Schema>::parse(int argc, const char* const argv[], int mode /*= PREFER_FLAG_FOR_UNREG_OPTION*/)
+   {
+      for (auto& option : options_)
+         option = option_state();
+      pos_args_.clear();
+      unknown_flags_.clear();
+      unknown_params_.clear();
+
+      args_.assign(argv, argv + argc);
+
+      arg_sink sink{ *this };
+      remainder_first_ = detail::scan_args<std::string_view>(args_, args_.size(), mode, sink);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline void static_parser<Schema>::arg_sink::flag(std::string_view name)
+   {
+      auto const option = index::table.find(name);
+      if (index::npos != option)
+         parser.options_[option].flag = true;
+      else
+         parser.unknown_flags_.push_back(name);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline void static_parser<Schema>::arg_sink::param(std::string_view name, std::string_view value)
+   {
+      auto const option = index::table.find(name);
+      if (index::npos == option)
+      {
+         parser.unknown_params_.emplace_back(name, value);
+         return;
+      }
+
+      auto& state = parser.options_[option];
+      if (!state.has_value)
+      {
+         state.has_value = true;
+         state.value = value;
+      }
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline typename static_parser<Schema>::option_state const* static_parser<Schema>::find(std::string_view name) const
+   {
+      auto const option = index::find(name);
+      return index::npos != option ? &options_[option] : nullptr;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline bool static_parser<Schema>::operator[](std::string_view name) const
+   {
+      auto const option = find(name);
+      return option && option->flag;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline string_stream static_parser<Schema>::operator()(key k) const
+   {
+      auto& option = options_[k.index()];
+      if (option.has_value)
+         return make_string_stream(option.value);
+      return bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline string_stream static_parser<Schema>::operator()(std::string_view name) const
+   {
+      auto const option = find(name);
+      if (option && option->has_value)
+         return make_string_stream(option->value);
+      return bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline string_stream static_parser<Schema>::operator()(size_t ind) const
+   {
+      if (ind < pos_args_.size())
+         return make_string_stream(pos_args_[ind]);
+      return bad_stream();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   inline string_stream static_parser<Schema>::bad_stream()
+   {
+      string_stream bad;
+      bad.setstate(std::ios_base::failbit);
+      return bad;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   template<typename T>
+   result<T> static_parser<Schema>::convert(option_state const* option)
+   {
+      if (!option || !option->has_value)
+         return get_status::MISSING;
+      return convert<T>(option->value);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   template<typename T>
+   result<T> static_parser<Schema>::convert(std::string_view arg)
+   {
+      T value;
+      if (!detail::convert(arg.data(), arg.data() + arg.size(), value))
+         return get_status::BAD_CONVERSION;
+      return result<T>(std::move(value));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   template<typename T>
+   result<T> static_parser<Schema>::get(key k) const
+   {
+      return convert<T>(&options_[k.index()]);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   template<typename T>
+   result<T> static_parser<Schema>::get(std::string_view name) const
+   {
+      return convert<T>(find(name));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename Schema>
+   template<typename T>
+   result<T> static_parser<Schema>::get(size_t ind) const
+   {
+      if (pos_args_.size() <= ind)
+         return get_status::MISSING;
+      return convert<T>(pos_args_[ind]);
+   }
+#endif
+
+#if defined(ARGH_HAS_STRING_VIEW)
+   //////////////////////////////////////////////////////////////////////////
+   // Batch parsing: many command lines parsed at once, possibly in parallel, into one compact result.
+
+   // A read-only set of registered param names, shared by all the lines of a batch.
+   class param_names
    {
    public:
-      using container_t = std::multimap<std::string, std::string>;
-      using iterator_t = container_t::const_iterator;
-      using difference_t = container_t::difference_type;
-      explicit multimap_iteration_wrapper(const iterator_t& lb, const iterator_t& ub)
-         : lb_(lb)
-         , ub_(ub)
+      param_names() = default;
+
+      param_names(std::initializer_list<char const* const> names)
+         : param_names(names.begin(), names.end())
       {}
 
-      iterator_t begin() const { return lb_; }
-      iterator_t end() const { return ub_; }
-      difference_t size() const { return std::distance(lb_, ub_); }
+      template<typename It>
+      param_names(It first, It last)
+      {
+         for (; first != last; ++first)
+            names_.emplace_back(detail::trim_leading_dashes(std::string_view(*first)));
+         std::sort(names_.begin(), names_.end());
+      }
+
+      bool contains(std::string_view name) const
+      {
+         auto it = std::lower_bound(names_.begin(), names_.end(), name, [](std::string const& lhs, std::string_view rhs) { return lhs < rhs; });
+         return names_.end() != it && *it == name;
+      }
 
    private:
-      iterator_t lb_;
-      iterator_t ub_;
+      std::vector<std::string> names_;
    };
 
-   class parser
+   // Runs the tasks of a batch one after the other, on the calling thread.
+   // parse_batch() accepts any other executor: a callable that runs task(i) for every i in [0, task_count),
+   // possibly concurrently, and returns once all of them are done.
+   struct serial_executor
    {
-   public:
-      enum Mode { PREFER_FLAG_FOR_UNREG_OPTION = 1 << 0,
-                  PREFER_PARAM_FOR_UNREG_OPTION = 1 << 1,
-                  NO_SPLIT_ON_EQUALSIGN = 1 << 2,
-                  SINGLE_DASH_IS_MULTIFLAG = 1 << 3,
-                };
+      template<typename Task>
+      void operator()(size_t task_count, Task&& task) const
+      {
+         for (size_t i = 0; i < task_count; ++i)
+            task(i);
+      }
+   };
 
-      parser() = default;
+#if defined(ARGH_ENABLE_THREADS)
+   // Runs the tasks of a batch on up to max_threads threads, the calling one included.
+   // 0 uses std::thread::hardware_concurrency() threads. If a task throws, no more tasks are started, and the
+   // exception is rethrown on the calling thread once all the threads are joined.
+   struct thread_executor
+   {
+      unsigned max_threads = 0;
 
-      parser(std::initializer_list<char const* const> pre_reg_names)
-      {  add_params(pre_reg_names); }
+      template<typename Task>
+      void operator()(size_t task_count, Task&& task) const
+      {
+         unsigned threads = max_threads ? max_threads : std::max(1u, std::thread::hardware_concurrency());
+         if (task_count < threads)
+            threads = static_cast<unsigned>(task_count);
 
-      parser(const char* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION)
-      {  parse(argv, mode); }
+         std::atomic<size_t> next(0);
+         std::vector<std::exception_ptr> errors(threads); // the first exception of each thread
+         auto run = [&](unsigned t)
+         {
+            try
+            {
+               for (auto i = next++; i < task_count; i = next++)
+                  task(i);
+            }
+            catch (...)
+            {
+               errors[t] = std::current_exception();
+               next = task_count;
+            }
+         };
 
-      parser(int argc, const char* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION)
-      {  parse(argc, argv, mode); }
+         {
+            // joined on every path, also when starting a thread throws
+            struct joiner
+            {
+               std::vector<std::thread> pool;
+               ~joiner()
+               {
+                  for (auto& thread : pool)
+                     thread.join();
+               }
+            } threads_joiner;
+            for (unsigned t = 1; t < threads; ++t)
+               threads_joiner.pool.emplace_back(run, t);
+            run(0);
+         }
 
-      void add_param(std::string const& name);
-      void add_params(std::string const& name);
+         for (auto& error : errors)
+            if (error)
+               std::rethrow_exception(error);
+      }
+   };
 
-      void add_param(std::initializer_list<char const* const> init_list);
-      void add_params(std::initializer_list<char const* const> init_list);
+   using default_executor = thread_executor;
+#else
+   using default_executor = serial_executor;
+#endif
 
-      void parse(const char* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION);
-      void parse(int argc, const char* const argv[], int mode = PREFER_FLAG_FOR_UNREG_OPTION);
+   // The results of parse_batch(): parsed lines sharing the same arrays of flags, params and positional args.
+   // These refer back into the parsed argvs, which must outlive the batch, or into the batch's copies of parsed strings.
+   class parsed_batch
+   {
+   public:
+      using string_type = std::string_view;
+      using param_type = std::pair<std::string_view, std::string_view>;
+      using flags_range = basic_multimap_iteration_wrapper<std::vector<std::string_view>>;
+      using params_range = basic_multimap_iteration_wrapper<std::vector<param_type>>;
+      using pos_args_range = basic_multimap_iteration_wrapper<std::vector<std::string_view>>;
 
-      std::multiset<std::string>               const& flags()    const { return flags_;    }
-      std::multimap<std::string, std::string>  const& params()   const { return params_;   }
-      multimap_iteration_wrapper                      params(std::string const& name) const;
-      std::vector<std::string>                 const& pos_args() const { return pos_args_; }
+      // One parsed command line, with the accessors of parser.
+      // Flags and params are sorted by name, the values of a repeated param stay in order of appearance.
+      class line
+      {
+      public:
+         flags_range    const& flags()    const { return flags_;    }
+         params_range   const& params()   const { return params_;   }
+         params_range          params(std::string_view name) const;
+         pos_args_range const& pos_args() const { return pos_args_; }
+         pos_args_range const& remainder() const { return remainder_; } // see parser::remainder()
 
-      // begin() and end() for using range-for over positional args.
-      std::vector<std::string>::const_iterator begin() const { return pos_args_.cbegin(); }
-      std::vector<std::string>::const_iterator end()   const { return pos_args_.cend();   }
-      size_t size()                                    const { return pos_args_.size();   }
+         pos_args_range::iterator_t begin() const { return pos_args_.begin(); }
+         pos_args_range::iterator_t end()   const { return pos_args_.end();   }
+         size_t size()                      const { return static_cast<size_t>(pos_args_.size()); }
 
-      //////////////////////////////////////////////////////////////////////////
-      // Accessors
+         bool operator[](std::string_view name) const;
+         std::string_view operator[](size_t ind) const;
 
-      // flag (boolean) accessors: return true if the flag appeared, otherwise false.
-      bool operator[](std::string const& name) const;
+         string_stream operator()(std::string_view name) const;
+         string_stream operator()(size_t ind) const;
 
-      // multiple flag (boolean) accessors: return true if at least one of the flag appeared, otherwise false.
-      bool operator[](std::initializer_list<char const* const> init_list) const;
+         template<typename T>
+         result<T> get(std::string_view name) const;
 
-      // returns positional arg string by order. Like argv[] but without the options
-      std::string const& operator[](size_t ind) const;
+         template<typename T>
+         result<T> get(size_t ind) const;
 
-      // returns a std::istream that can be used to convert a positional arg to a typed value.
-      string_stream operator()(size_t ind) const;
+      private:
+         friend class parsed_batch;
+         line(flags_range const& flags, params_range const& params, pos_args_range const& pos_args, pos_args_range const& remainder)
+            : flags_(flags), params_(params), pos_args_(pos_args), remainder_(remainder)
+         {}
 
-      // same as above, but with a default value in case the arg is missing (index out of range).
-      template<typename T>
-      string_stream operator()(size_t ind, T&& def_val) const;
+         static string_stream bad_stream();
+         template<typename T>
+         static result<T> convert(std::string_view arg);
 
-      // parameter accessors, give a name get an std::istream that can be used to convert to a typed value.
-      // call .str() on result to get as string
-      string_stream operator()(std::string const& name) const;
+         flags_range flags_;
+         params_range params_;
+         pos_args_range pos_args_;
+         pos_args_range remainder_;
+      };
 
-      // accessor for a parameter with multiple names, give a list of names, get an std::istream that can be used to convert to a typed value.
-      // call .str() on result to get as string
-      // returns the first value in the list to be found.
-      string_stream operator()(std::initializer_list<char const* const> init_list) const;
+      // The lines parsed by one task of parse_batch()
+      struct part
+      {
+         std::vector<std::string_view> flags;
+         std::vector<param_type> params;
+         std::vector<std::string_view> pos_args;
+         std::vector<std::string_view> remainders;
+         std::vector<std::array<size_t, 4>> line_ends; // where each line ends in flags, params, pos_args and remainders
+         std::unique_ptr<char[]> buffer;              // unquoted copies of the parsed strings
+      };
 
-      // same as above, but with a default value in case the param was missing.
-      // Non-string def_val types must have an operator<<() (output stream operator)
-      // If T only has an input stream operator, pass the string version of the type as in "3" instead of 3.
-      template<typename T>
-      string_stream operator()(std::string const& name, T&& def_val) const;
+      parsed_batch() = default;
 
-      // same as above but for a list of names. returns the first value to be found.
-      template<typename T>
-      string_stream operator()(std::initializer_list<char const* const> init_list, T&& def_val) const;
+      // concatenates the parts, in order
+      explicit parsed_batch(std::vector<part>&& parts);
 
-   private:
-      string_stream bad_stream() const;
-      std::string trim_leading_dashes(std::string const& name) const;
-      bool is_number(std::string const& arg) const;
-      bool is_option(std::string const& arg) const;
-      bool got_flag(std::string const& name) const;
-      bool is_param(std::string const& name) const;
+      size_t size() const { return lines_.empty() ? 0 : lines_.size() - 1; }
+      line operator[](size_t ind) const;
 
    private:
-      std::vector<std::string> args_;
-      std::multimap<std::string, std::string> params_;
-      std::vector<std::string> pos_args_;
-      std::multiset<std::string> flags_;
-      std::set<std::string> registeredParams_;
-      std::string empty_;
+      std::vector<std::string_view> flags_;
+      std::vector<param_type> params_;
+      std::vector<std::string_view> pos_args_;
+      std::vector<std::string_view> remainders_;
+      std::vector<std::array<size_t, 4>> lines_; // where each line starts, then where the last one ends
+      std::vector<std::unique_ptr<char[]>> buffers_;
    };
 
-
-   //////////////////////////////////////////////////////////////////////////
-
-   inline void parser::parse(const char * const argv[], int mode)
+   namespace detail
    {
-      int argc = 0;
-      for (auto argvp = argv; *argvp; ++argc, ++argvp);
-      parse(argc, argv, mode);
-   }
+      struct batch_sink
+      {
+         param_names const& registered;
+         parsed_batch::part& out;
+         bool is_param(std::string_view name) const                { return registered.contains(name); }
+         bool is_flag(std::string_view) const                      { return false; }
+         bool is_subcommand(std::string_view) const                { return false; }
+         void flag(std::string_view name)                          { out.flags.push_back(name); }
+         void param(std::string_view name, std::string_view value) { out.params.emplace_back(name, value); }
+         void positional(std::string_view arg)                     { out.pos_args.push_back(arg); }
+      };
 
-   //////////////////////////////////////////////////////////////////////////
+      // a line is either an argv (nullptr terminated) or a command line string, split as by parser::parse_string()
+      inline size_t batch_line_size(char const* const*) { return 0; }
+      inline size_t batch_line_size(std::string_view line) { return line.size(); }
 
-   inline void parser::parse(int argc, const char* const argv[], int mode /*= PREFER_FLAG_FOR_UNREG_OPTION*/)
-   {
-      // clear out possible previous parsing remnants
-      flags_.clear();
-      params_.clear();
-      pos_args_.clear();
+      inline void append_batch_line(std::vector<std::string_view>& args, char const* const* argv, char*&)
+      {
+         for (; *argv; ++argv)
+            args.emplace_back(*argv);
+      }
 
-      // convert to strings
-      args_.resize(static_cast<decltype(args_)::size_type>(argc));
-      std::transform(argv, argv + argc, args_.begin(), [](const char* const arg) { return arg;  });
+      inline void append_batch_line(std::vector<std::string_view>& args, std::string_view line, char*& buffer)
+      {
+         auto const last = std::copy(line.begin(), line.end(), buffer);
+         split_command_line(buffer, last, [&](char* first, char* token_last) { args.emplace_back(first, static_cast<size_t>(token_last - first)); });
+         buffer = last;
+      }
 
-      // parse line
-      for (auto i = 0u; i < args_.size(); ++i)
+      template<typename It>
+      void parse_batch_part(It first, size_t count, int mode, param_names const& registered, parsed_batch::part& out)
       {
-         if (!is_option(args_[i]))
+         size_t buffer_size = 0;
+         auto it = first;
+         for (size_t l = 0; l < count; ++l, ++it)
+            buffer_size += batch_line_size(*it);
+         if (buffer_size)
+            out.buffer.reset(new char[buffer_size]);
+         auto buffer = out.buffer.get();
+
+         batch_sink sink{ registered, out };
+         std::vector<std::string_view> args;
+         out.line_ends.reserve(count);
+         for (size_t l = 0; l < count; ++l, ++first)
          {
-            pos_args_.emplace_back(args_[i]);
-            continue;
-         }
+            args.clear();
+            append_batch_line(args, *first, buffer);
 
-         auto name = trim_leading_dashes(args_[i]);
+            auto const flags_start = static_cast<std::ptrdiff_t>(out.flags.size());
+            auto const params_start = static_cast<std::ptrdiff_t>(out.params.size());
+            auto const remainder = static_cast<std::ptrdiff_t>(scan_args<std::string_view>(args, args.size(), mode, sink));
+            out.remainders.insert(out.remainders.end(), args.begin() + remainder, args.end());
+            std::sort(out.flags.begin() + flags_start, out.flags.end());
+            std::stable_sort(out.params.begin() + params_start, out.params.end(),
+               [](parsed_batch::param_type const& lhs, parsed_batch::param_type const& rhs) { return lhs.first < rhs.first; });
 
-         if (!(mode & NO_SPLIT_ON_EQUALSIGN))
-         {
-            auto equalPos = name.find('=');
-            if (equalPos != std::string::npos)
-            {
-               params_.insert({ name.substr(0, equalPos), name.substr(equalPos + 1) });
-               continue;
-            }
+            out.line_ends.push_back({ { out.flags.size(), out.params.size(), out.pos_args.size(), out.remainders.size() } });
          }
+      }
+   }
 
-         // if the option is unregistered and should be a multi-flag
-         if (1 == (args_[i].size() - name.size()) &&         // single dash
-            argh::parser::SINGLE_DASH_IS_MULTIFLAG & mode && // multi-flag mode
-            !is_param(name))                                  // unregistered
-         {
-            std::string keep_param;
+   // Parses each of lines, a random access range of argvs (nullptr terminated) or of command line strings,
+   // with the given mode and registered params. The lines are split in parts of a few hundreds, parsed by
+   // the executor's tasks, see serial_executor and thread_executor. EXPAND_RESPONSE_FILES is not supported here.
+   template<typename Lines, typename Executor = default_executor>
+   parsed_batch parse_batch(Lines const& lines, int mode = parser_base::PREFER_FLAG_FOR_UNREG_OPTION,
+                            param_names const& registered = param_names(), Executor&& executor = Executor())
+   {
+      size_t const lines_per_part = 256;
+      auto const first = std::begin(lines);
+      auto const count = static_cast<size_t>(std::distance(first, std::end(lines)));
 
-            if (!name.empty() && is_param(std::string(1ul, name.back()))) // last char is param
-            {
-               keep_param += name.back();
-               name.resize(name.size() - 1);
-            }
+      std::vector<parsed_batch::part> parts((count + lines_per_part - 1) / lines_per_part);
+      executor(parts.size(), [&](size_t i)
+      {
+         auto const part_first = i * lines_per_part;
+         detail::parse_batch_part(first + static_cast<std::ptrdiff_t>(part_first), std::min(lines_per_part, count - part_first),
+                                  mode, registered, parts[i]);
+      });
+      return parsed_batch(std::move(parts));
+   }
 
-            for (auto const& c : name)
-            {
-               flags_.emplace(std::string{ c });
-            }
+   //////////////////////////////////////////////////////////////////////////
 
-            if (!keep_param.empty())
-            {
-               name = keep_param;
-            }
-            else
-            {
-               continue; // do not consider other options for this arg
-            }
-         }
+   inline parsed_batch::parsed_batch(std::vector<part>&& parts)
+   {
+      std::array<size_t, 4> totals = { { 0, 0, 0, 0 } };
+      size_t line_count = 0;
+      for (auto& p : parts)
+      {
+         totals[0] += p.flags.size();
+         totals[1] += p.params.size();
+         totals[2] += p.pos_args.size();
+         totals[3] += p.remainders.size();
+         line_count += p.line_ends.size();
+      }
+      flags_.reserve(totals[0]);
+      params_.reserve(totals[1]);
+      pos_args_.reserve(totals[2]);
+      remainders_.reserve(totals[3]);
+      lines_.reserve(line_count + 1);
 
-         // any potential option will get as its value the next arg, unless that arg is an option too
-         // in that case it will be determined a flag.
-         if (i == args_.size() - 1 || is_option(args_[i + 1]))
-         {
-            flags_.emplace(name);
-            continue;
-         }
+      lines_.push_back({ { 0, 0, 0, 0 } });
+      for (auto& p : parts)
+      {
+         std::array<size_t, 4> const base = { { flags_.size(), params_.size(), pos_args_.size(), remainders_.size() } };
+         flags_.insert(flags_.end(), p.flags.begin(), p.flags.end());
+         params_.insert(params_.end(), p.params.begin(), p.params.end());
+         pos_args_.insert(pos_args_.end(), p.pos_args.begin(), p.pos_args.end());
+         remainders_.insert(remainders_.end(), p.remainders.begin(), p.remainders.end());
+         for (auto& ends : p.line_ends)
+            lines_.push_back({ { base[0] + ends[0], base[1] + ends[1], base[2] + ends[2], base[3] + ends[3] } });
+         if (p.buffer)
+            buffers_.push_back(std::move(p.buffer));
+      }
+   }
 
-         // if 'name' is a pre-registered option, then the next arg cannot be a free parameter to it is skipped
-         // otherwise we have 2 modes:
-         // PREFER_FLAG_FOR_UNREG_OPTION: a non-registered 'name' is determined a flag.
-         //                               The following value (the next arg) will be a free parameter.
-         //
-         // PREFER_PARAM_FOR_UNREG_OPTION: a non-registered 'name' is determined a parameter, the next arg
-         //                                will be the value of that option.
+   //////////////////////////////////////////////////////////////////////////
 
-         assert(!(mode & argh::parser::PREFER_FLAG_FOR_UNREG_OPTION)
-             || !(mode & argh::parser::PREFER_PARAM_FOR_UNREG_OPTION));
+   inline parsed_batch::line parsed_batch::operator[](size_t ind) const
+   {
+      auto const& starts = lines_[ind];
+      auto const& ends = lines_[ind + 1];
+      auto const at = [](size_t offset) { return static_cast<std::ptrdiff_t>(offset); };
+      return line(flags_range(flags_.begin() + at(starts[0]), flags_.begin() + at(ends[0])),
+                  params_range(params_.begin() + at(starts[1]), params_.begin() + at(ends[1])),
+                  pos_args_range(pos_args_.begin() + at(starts[2]), pos_args_.begin() + at(ends[2])),
+                  pos_args_range(remainders_.begin() + at(starts[3]), remainders_.begin() + at(ends[3])));
+   }
 
-         bool preferParam = mode & argh::parser::PREFER_PARAM_FOR_UNREG_OPTION;
+   //////////////////////////////////////////////////////////////////////////
 
-         if (is_param(name) || preferParam)
-         {
-            params_.insert({ name, args_[i + 1] });
-            ++i; // skip next value, it is not a free parameter
-            continue;
-         }
-         else
-         {
-            flags_.emplace(name);
-         }
-      }
+   inline parsed_batch::params_range parsed_batch::line::params(std::string_view name) const
+   {
+      struct by_name
+      {
+         bool operator()(param_type const& lhs, std::string_view rhs) const { return lhs.first < rhs; }
+         bool operator()(std::string_view lhs, param_type const& rhs) const { return lhs < rhs.first; }
+      };
+      auto const range = std::equal_range(params_.begin(), params_.end(), detail::trim_leading_dashes(name), by_name());
+      return params_range(range.first, range.second);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   inline bool parsed_batch::line::operator[](std::string_view name) const
+   {
+      return std::binary_search(flags_.begin(), flags_.end(), detail::trim_leading_dashes(name));
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline string_stream parser::bad_stream() const
+   inline std::string_view parsed_batch::line::operator[](size_t ind) const
+   {
+      if (ind < size())
+         return begin()[static_cast<std::ptrdiff_t>(ind)];
+      return std::string_view();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   inline string_stream parsed_batch::line::bad_stream()
    {
       string_stream bad;
       bad.setstate(std::ios_base::failbit);
@@ -300,186 +5353,427 @@ namespace argh
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline bool parser::is_number(std::string const& arg) const
+   inline string_stream parsed_batch::line::operator()(std::string_view name) const
    {
-      // inefficient but simple way to determine if a string is a number (which can start with a '-')
-      std::istringstream istr(arg);
-      double number;
-      istr >> number;
-      return !(istr.fail() || istr.bad());
+      auto const values = params(name);
+      if (0 == values.size())
+         return bad_stream();
+      return make_string_stream(values.begin()->second);
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline bool parser::is_option(std::string const& arg) const
+   inline string_stream parsed_batch::line::operator()(size_t ind) const
    {
-      assert(0 != arg.size());
-      if (is_number(arg))
-         return false;
-      return '-' == arg[0];
+      if (size() <= ind)
+         return bad_stream();
+      return make_string_stream((*this)[ind]);
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline std::string parser::trim_leading_dashes(std::string const& name) const
+   template<typename T>
+   result<T> parsed_batch::line::convert(std::string_view arg)
    {
-      auto pos = name.find_first_not_of('-');
-      return std::string::npos != pos ? name.substr(pos) : name;
+      T value;
+      if (!detail::convert(arg.data(), arg.data() + arg.size(), value))
+         return get_status::BAD_CONVERSION;
+      return result<T>(std::move(value));
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline bool argh::parser::got_flag(std::string const& name) const
+   template<typename T>
+   result<T> parsed_batch::line::get(std::string_view name) const
    {
-      return flags_.end() != flags_.find(trim_leading_dashes(name));
+      auto const values = params(name);
+      if (0 == values.size())
+         return get_status::MISSING;
+      return convert<T>(values.begin()->second);
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline bool argh::parser::is_param(std::string const& name) const
+   template<typename T>
+   result<T> parsed_batch::line::get(size_t ind) const
    {
-      return registeredParams_.count(name);
+      if (size() <= ind)
+         return get_status::MISSING;
+      return convert<T>((*this)[ind]);
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline bool parser::operator[](std::string const& name) const
+   namespace detail
    {
-      return got_flag(name);
+      template<typename Visitor>
+      struct visit_sink
+      {
+         param_names const& registered;
+         Visitor& visitor;
+         bool is_param(std::string_view name) const                { return registered.contains(name); }
+         bool is_flag(std::string_view) const                      { return false; }
+         bool is_subcommand(std::string_view) const                { return false; }
+         void flag(std::string_view name)                          { visitor.on_flag(name); }
+         void param(std::string_view name, std::string_view value) { visitor.on_param(name, value); }
+         void positional(std::string_view arg)                     { visitor.on_positional(arg); }
+      };
+   }
+
+   // Classifies the argc args of argv exactly like parser::parse() with the given mode and registered params,
+   // but only tells the visitor what it finds, in order of appearance, without storing or allocating anything:
+   //    visitor.on_flag(std::string_view name)
+   //    visitor.on_param(std::string_view name, std::string_view value)
+   //    visitor.on_positional(std::string_view arg)
+   // Returns where the args left unparsed start: after the "--" that ended the options in DOUBLE_DASH_ENDS_OPTIONS
+   // mode, else argc. EXPAND_RESPONSE_FILES is not supported here.
+   template<typename Visitor>
+   int visit(int argc, char const* const argv[], int mode, Visitor&& visitor, param_names const& registered = param_names())
+   {
+      detail::visit_sink<typename std::remove_reference<Visitor>::type> sink{ registered, visitor };
+      detail::arg_scanner<std::string_view, std::string_view, decltype(sink)> scanner(mode, sink);
+
+      // the scanner refers to the arg pending before the one pushed
+      std::string_view args[2];
+      for (int i = 0; i < argc; ++i)
+      {
+         args[i & 1] = argv[i];
+         if (!scanner.push(args[i & 1]))
+            break;
+      }
+      return static_cast<int>(scanner.finish());
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline bool parser::operator[](std::initializer_list<char const* const> init_list) const
+   // Reads a snapshot made by parser::serialize() in place, without copying or unpacking it: accessing it only
+   // searches the sorted tables of the snapshot. The snapshot must outlive the frozen_parser, and come from
+   // a machine with the same byte order.
+   // An indexed frozen_parser (see make() and parser::freeze()) owns its snapshot, and finds names by hash instead.
+   // Nothing is modified by the accessors: a frozen_parser can be read by any number of threads at once.
+   class frozen_parser
    {
-      return std::any_of(init_list.begin(), init_list.end(), [&](char const* const name) { return got_flag(name); });
-   }
+   public:
+      frozen_parser() = default;
+
+      // refers to the snapshot of size bytes at data. Returns false, leaving the parser empty, if it is not one.
+      bool attach(void const* data, size_t size);
+
+      // takes a snapshot and indexes its names, nullptr if it is not one
+      static std::shared_ptr<frozen_parser const> make(std::string snapshot);
+
+      size_t size()           const { return pos_arg_count_;   } // positional args
+      size_t remainder_size() const { return remainder_count_; }
+      std::string_view remainder(size_t ind) const;
+
+      bool operator[](std::string_view name) const;
+      std::string_view operator[](size_t ind) const;
+
+      // the first value of a param, else its fallback value
+      string_stream operator()(std::string_view name) const;
+      string_stream operator()(size_t ind) const;
+
+      template<typename T>
+      result<T> get(std::string_view name) const;
+
+      template<typename T>
+      result<T> get(size_t ind) const;
+
+   private:
+      using format = detail::frozen_format;
+
+      bool attach_bytes(void const* data, size_t size);
+      std::string_view ref(size_t i) const; // the string of ref i of the table
+      size_t lower_bound(size_t first, size_t count, size_t stride, std::string_view name) const;
+      bool find(std::string_view name, std::string_view& value) const;
+      static string_stream bad_stream();
+
+      // open addressing tables of (ref + 1, hash) pairs of words, a power of 2 of them, 0 for an empty slot
+      static std::vector<uint32_t> make_index(size_t count);
+      static void index_ref(std::vector<uint32_t>& index, size_t i, std::string_view name);
+      size_t find_ref(std::vector<uint32_t> const& index, std::string_view name) const; // size_t(-1) if missing
+
+      char const* table_ = nullptr;
+      char const* strings_ = nullptr;
+      size_t flag_count_ = 0;
+      size_t param_count_ = 0;
+      size_t pos_arg_count_ = 0;
+      size_t remainder_count_ = 0;
+      size_t fallback_count_ = 0;
+
+      std::shared_ptr<std::string const> snapshot_; // when made from a snapshot
+      std::vector<uint32_t> flag_index_;            // unique flag names
+      std::vector<uint32_t> value_index_;           // first value of each param, else fallback value
+   };
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline std::string const& parser::operator[](size_t ind) const
+   inline bool frozen_parser::attach(void const* data, size_t size)
    {
-      if (ind < pos_args_.size())
-         return pos_args_[ind];
-      return empty_;
+      *this = frozen_parser();
+      return attach_bytes(data, size);
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline string_stream parser::operator()(std::string const& name) const
+   inline bool frozen_parser::attach_bytes(void const* data, size_t size)
    {
-      auto optIt = params_.find(trim_leading_dashes(name));
-      if (params_.end() != optIt)
-         return string_stream(optIt->second);
-      return bad_stream();
+      auto const bytes = static_cast<char const*>(data);
+      size_t const header_size = format::header_words * sizeof(uint32_t);
+      if (!bytes || size < header_size || format::magic != format::word(bytes, format::magic_word) || format::version != format::word(bytes, format::version_word))
+         return false;
+
+      size_t const refs = size_t(format::word(bytes, format::flag_count)) + 2 * size_t(format::word(bytes, format::param_count))
+                        + format::word(bytes, format::pos_arg_count) + format::word(bytes, format::remainder_count) + 2 * size_t(format::word(bytes, format::fallback_count));
+      size_t const strings_size = format::word(bytes, format::strings_size);
+      if (size != header_size + 2 * refs * sizeof(uint32_t) + strings_size)
+         return false;
+
+      auto const table = bytes + header_size;
+      for (size_t i = 0; i < refs; ++i)
+      {
+         size_t const offset = format::word(table, 2 * i);
+         size_t const length = format::word(table, 2 * i + 1);
+         if (strings_size < offset || strings_size - offset < length)
+            return false;
+      }
+
+      table_ = table;
+      strings_ = table + 2 * refs * sizeof(uint32_t);
+      flag_count_ = format::word(bytes, format::flag_count);
+      param_count_ = format::word(bytes, format::param_count);
+      pos_arg_count_ = format::word(bytes, format::pos_arg_count);
+      remainder_count_ = format::word(bytes, format::remainder_count);
+      fallback_count_ = format::word(bytes, format::fallback_count);
+      return true;
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline string_stream parser::operator()(std::initializer_list<char const* const> init_list) const
+   inline std::shared_ptr<frozen_parser const> frozen_parser::make(std::string snapshot)
    {
-      for (auto& name : init_list)
+      auto frozen = std::make_shared<frozen_parser>();
+      frozen->snapshot_ = std::make_shared<std::string const>(std::move(snapshot));
+      if (!frozen->attach_bytes(frozen->snapshot_->data(), frozen->snapshot_->size()))
+         return nullptr;
+
+      auto& flags = frozen->flag_index_;
+      flags = make_index(frozen->flag_count_);
+      for (size_t i = 0; i < frozen->flag_count_; ++i)
+         if (0 == i || frozen->ref(i) != frozen->ref(i - 1))
+            index_ref(flags, i, frozen->ref(i));
+
+      // params before fallback values, so that a fallback name already indexed is skipped
+      auto& values = frozen->value_index_;
+      values = make_index(frozen->param_count_ + frozen->fallback_count_);
+      size_t const params = frozen->flag_count_;
+      for (size_t p = 0; p < frozen->param_count_; ++p)
       {
-         auto optIt = params_.find(trim_leading_dashes(name));
-         if (params_.end() != optIt)
-            return string_stream(optIt->second);
+         auto const i = params + 2 * p;
+         if (0 == p || frozen->ref(i) != frozen->ref(i - 2))
+            index_ref(values, i, frozen->ref(i));
       }
-      return bad_stream();
+      size_t const fallback = params + 2 * frozen->param_count_ + frozen->pos_arg_count_ + frozen->remainder_count_;
+      for (size_t f = 0; f < frozen->fallback_count_; ++f)
+      {
+         auto const i = fallback + 2 * f;
+         if (size_t(-1) == frozen->find_ref(values, frozen->ref(i)))
+            index_ref(values, i, frozen->ref(i));
+      }
+      return frozen;
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   template<typename T>
-   string_stream parser::operator()(std::string const& name, T&& def_val) const
+   inline std::vector<uint32_t> frozen_parser::make_index(size_t count)
    {
-      auto optIt = params_.find(trim_leading_dashes(name));
-      if (params_.end() != optIt)
-         return string_stream(optIt->second);
+      size_t slots = 8;
+      while (slots < 2 * count) // at most half full
+         slots *= 2;
+      return std::vector<uint32_t>(2 * slots, 0);
+   }
 
-      std::ostringstream ostr;
-      ostr.precision(std::numeric_limits<long double>::max_digits10);
-      ostr << def_val;
-      return string_stream(ostr.str()); // use default
+   //////////////////////////////////////////////////////////////////////////
+
+   inline void frozen_parser::index_ref(std::vector<uint32_t>& index, size_t i, std::string_view name)
+   {
+      auto const hash = static_cast<uint32_t>(std::hash<std::string_view>()(name));
+      size_t const mask = index.size() / 2 - 1;
+      auto slot = hash & mask;
+      while (index[2 * slot])
+         slot = (slot + 1) & mask;
+      index[2 * slot] = static_cast<uint32_t>(i + 1);
+      index[2 * slot + 1] = hash;
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   // same as above but for a list of names. returns the first value to be found.
-   template<typename T>
-   string_stream parser::operator()(std::initializer_list<char const* const> init_list, T&& def_val) const
+   inline size_t frozen_parser::find_ref(std::vector<uint32_t> const& index, std::string_view name) const
    {
-      for (auto& name : init_list)
+      auto const hash = static_cast<uint32_t>(std::hash<std::string_view>()(name));
+      size_t const mask = index.size() / 2 - 1;
+      for (auto slot = hash & mask; index[2 * slot]; slot = (slot + 1) & mask)
       {
-         auto optIt = params_.find(trim_leading_dashes(name));
-         if (params_.end() != optIt)
-            return string_stream(optIt->second);
+         auto const i = size_t(index[2 * slot]) - 1;
+         if (hash == index[2 * slot + 1] && ref(i) == name)
+            return i;
       }
-      std::ostringstream ostr;
-      ostr.precision(std::numeric_limits<long double>::max_digits10);
-      ostr << def_val;
-      return string_stream(ostr.str()); // use default
+      return size_t(-1);
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline string_stream parser::operator()(size_t ind) const
+   inline std::string_view frozen_parser::ref(size_t i) const
    {
-      if (pos_args_.size() <= ind)
-         return bad_stream();
+      return std::string_view(strings_ + format::word(table_, 2 * i), format::word(table_, 2 * i + 1));
+   }
 
-      return string_stream(pos_args_[ind]);
+   //////////////////////////////////////////////////////////////////////////
+
+   // the first of the count entries of stride refs from ref first whose name (the first ref) is not less than name
+   inline size_t frozen_parser::lower_bound(size_t first, size_t count, size_t stride, std::string_view name) const
+   {
+      while (0 < count)
+      {
+         auto const half = count / 2;
+         if (ref(first + half * stride) < name)
+         {
+            first += (half + 1) * stride;
+            count -= half + 1;
+         }
+         else
+         {
+            count = half;
+         }
+      }
+      return first;
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   template<typename T>
-   string_stream parser::operator()(size_t ind, T&& def_val) const
+   inline bool frozen_parser::find(std::string_view name, std::string_view& value) const
    {
-      if (pos_args_.size() <= ind)
+      name = detail::trim_leading_dashes(name);
+      if (!value_index_.empty())
       {
-         std::ostringstream ostr;
-         ostr.precision(std::numeric_limits<long double>::max_digits10);
-         ostr << def_val;
-         return string_stream(ostr.str());
+         auto const i = find_ref(value_index_, name);
+         if (size_t(-1) == i)
+            return false;
+         value = ref(i + 1);
+         return true;
+      }
+
+      size_t const params = flag_count_;
+      size_t const params_end = params + 2 * param_count_;
+      auto const param = lower_bound(params, param_count_, 2, name);
+      if (params_end != param && ref(param) == name)
+      {
+         value = ref(param + 1);
+         return true;
       }
 
-      return string_stream(pos_args_[ind]);
+      size_t const fallback = params_end + pos_arg_count_ + remainder_count_;
+      size_t const fallback_end = fallback + 2 * fallback_count_;
+      auto const entry = lower_bound(fallback, fallback_count_, 2, name);
+      if (fallback_end != entry && ref(entry) == name)
+      {
+         value = ref(entry + 1);
+         return true;
+      }
+      return false;
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline void parser::add_param(std::string const& name)
+   inline bool frozen_parser::operator[](std::string_view name) const
    {
-      registeredParams_.insert(trim_leading_dashes(name));
+      name = detail::trim_leading_dashes(name);
+      if (!flag_index_.empty())
+         return size_t(-1) != find_ref(flag_index_, name);
+      auto const flag = lower_bound(0, flag_count_, 1, name);
+      return flag_count_ != flag && ref(flag) == name;
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline void parser::add_param(std::initializer_list<const char *const> init_list)
+   inline std::string_view frozen_parser::operator[](size_t ind) const
    {
-       parser::add_params(init_list);
+      if (ind < pos_arg_count_)
+         return ref(flag_count_ + 2 * param_count_ + ind);
+      return std::string_view();
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline void parser::add_params(std::initializer_list<char const* const> init_list)
+   inline std::string_view frozen_parser::remainder(size_t ind) const
    {
-      for (auto& name : init_list)
-         registeredParams_.insert(trim_leading_dashes(name));
+      if (ind < remainder_count_)
+         return ref(flag_count_ + 2 * param_count_ + pos_arg_count_ + ind);
+      return std::string_view();
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   inline string_stream frozen_parser::bad_stream()
+   {
+      string_stream bad;
+      bad.setstate(std::ios_base::failbit);
+      return bad;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   inline string_stream frozen_parser::operator()(std::string_view name) const
+   {
+      std::string_view value;
+      if (!find(name, value))
+         return bad_stream();
+      return make_string_stream(value);
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   inline string_stream frozen_parser::operator()(size_t ind) const
+   {
+      if (pos_arg_count_ <= ind)
+         return bad_stream();
+      return make_string_stream((*this)[ind]);
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline void parser::add_params(const std::string &name)
+   template<typename T>
+   result<T> frozen_parser::get(std::string_view name) const
+   {
+      std::string_view value;
+      if (!find(name, value))
+         return get_status::MISSING;
+      T converted;
+      if (!detail::convert(value.data(), value.data() + value.size(), converted))
+         return get_status::BAD_CONVERSION;
+      return result<T>(std::move(converted));
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+
+   template<typename T>
+   result<T> frozen_parser::get(size_t ind) const
    {
-       parser::add_param(name);
+      if (pos_arg_count_ <= ind)
+         return get_status::MISSING;
+      auto const arg = (*this)[ind];
+      T converted;
+      if (!detail::convert(arg.data(), arg.data() + arg.size(), converted))
+         return get_status::BAD_CONVERSION;
+      return result<T>(std::move(converted));
    }
 
    //////////////////////////////////////////////////////////////////////////
 
-   inline multimap_iteration_wrapper parser::params(std::string const& name) const
+   template<typename String, typename Storage>
+   inline std::shared_ptr<frozen_parser const> basic_parser<String, Storage>::freeze() const
    {
-      auto trimmed_name = trim_leading_dashes(name);
-      return multimap_iteration_wrapper(params_.lower_bound(trimmed_name), params_.upper_bound(trimmed_name));
+      return frozen_parser::make(serialize());
    }
+#endif
 }
@@ -0,0 +1,418 @@
+// Microbenchmarks of the parse and access hot paths.
+//
+// usage: argh_bench [--max-tokens=N] [--min-time=SECONDS] [--filter=TEXT]
+//
+// Every benchmark parses the same pseudo-random command lines (fixed seed) and reports:
+// - ns/token: the time per arg of a parse, or per access for the lookup benchmarks
+// - allocs: the allocations made by one parse (or one access)
+// - peak bytes: the most memory held at once during that parse, above what was held before it
+
+#include "argh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+// Allocation counting: a header in front of every block records its size.
+
+namespace
+{
+   struct allocation_stats
+   {
+      size_t count = 0;
+      size_t current = 0;
+      size_t peak = 0;
+   } g_stats;
+
+   // in front of every block, after the padding that aligns it
+   struct header
+   {
+      void* raw;
+      size_t size;
+   };
+
+   void* counted_alloc(size_t size, size_t alignment = alignof(std::max_align_t))
+   {
+      auto const raw = static_cast<char*>(std::malloc(sizeof(header) + alignment + size));
+      if (!raw)
+         throw std::bad_alloc();
+      auto const address = reinterpret_cast<std::uintptr_t>(raw) + sizeof(header);
+      auto const block = raw + (address + alignment - 1) / alignment * alignment - reinterpret_cast<std::uintptr_t>(raw);
+      header const h{ raw, size };
+      std::memcpy(block - sizeof(header), &h, sizeof(header));
+      ++g_stats.count;
+      g_stats.current += size;
+      g_stats.peak = std::max(g_stats.peak, g_stats.current);
+      return block;
+   }
+
+   void counted_free(void* p) noexcept
+   {
+      if (!p)
+         return;
+      header h;
+      std::memcpy(&h, static_cast<char*>(p) - sizeof(header), sizeof(header));
+      g_stats.current -= h.size;
+      std::free(h.raw);
+   }
+}
+
+void* operator new(size_t size)                 { return counted_alloc(size); }
+void* operator new[](size_t size)               { return counted_alloc(size); }
+void operator delete(void* p) noexcept          { counted_free(p); }
+void operator delete[](void* p) noexcept        { counted_free(p); }
+void operator delete(void* p, size_t) noexcept   { counted_free(p); }
+void operator delete[](void* p, size_t) noexcept { counted_free(p); }
+
+// std::pmr::new_delete_resource() allocates through these
+void* operator new(size_t size, std::align_val_t alignment)                  { return counted_alloc(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment)                { return counted_alloc(size, static_cast<size_t>(alignment)); }
+void operator delete(void* p, std::align_val_t) noexcept           { counted_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept         { counted_free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept   { counted_free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { counted_free(p); }
+
+namespace
+{
+   // the allocations made, and the peak memory held, from its construction to measure()
+   struct allocation_scope
+   {
+      size_t const count = g_stats.count;
+      size_t const current = g_stats.current;
+
+      allocation_scope() { g_stats.peak = g_stats.current; }
+
+      void measure(size_t& allocs, size_t& peak_bytes) const
+      {
+         allocs = g_stats.count - count;
+         peak_bytes = g_stats.peak - current;
+      }
+   };
+
+   //////////////////////////////////////////////////////////////////////////
+   // Command lines
+
+   struct command_line
+   {
+      std::vector<std::string> strings;
+      std::vector<char const*> argv;
+
+      int argc() const { return static_cast<int>(strings.size()); }
+   };
+
+   // a mix of the arg kinds of real command lines: flags, params with and without '=', multiflags,
+   // negative numbers and positional args. The names repeat, as options of a large command line do.
+   command_line make_command_line(size_t tokens, unsigned seed = 42)
+   {
+      std::mt19937 random(seed);
+      auto const pick = [&](unsigned n) { return static_cast<unsigned>(random() % n); };
+
+      command_line cmdl;
+      cmdl.strings.reserve(tokens);
+      cmdl.strings.emplace_back("app");
+      while (cmdl.strings.size() < tokens)
+      {
+         auto const id = std::to_string(pick(64));
+         switch (pick(8))
+         {
+         case 0: cmdl.strings.push_back("-v"); break;
+         case 1: cmdl.strings.push_back("--flag-" + id); break;
+         case 2: cmdl.strings.push_back("--param-" + id + "=value-" + id); break;
+         case 3: cmdl.strings.push_back("--jobs"); cmdl.strings.push_back(id); break;
+         case 4: cmdl.strings.push_back("-xvf"); break;
+         case 5: cmdl.strings.push_back("-" + id); break;
+         case 6: cmdl.strings.push_back("-t"); cmdl.strings.push_back("0." + id); break;
+         default: cmdl.strings.push_back("positional-arg-" + id); break;
+         }
+      }
+      cmdl.strings.resize(tokens);
+      for (auto const& arg : cmdl.strings)
+         cmdl.argv.push_back(arg.c_str());
+      cmdl.argv.push_back(nullptr);
+      return cmdl;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Running and reporting
+
+   struct options
+   {
+      size_t max_tokens = 1000000;
+      double min_time = 0.2;
+      std::string filter;
+   } g_options;
+
+   volatile size_t g_sink; // keeps the results of the benchmarks alive
+
+   using clock_type = std::chrono::steady_clock;
+
+   // runs body until min_time has passed, returns the ns per call to body
+   template<typename Body>
+   double time_per_call(Body&& body)
+   {
+      body(); // warm up
+      size_t calls = 0;
+      auto const start = clock_type::now();
+      auto elapsed = clock_type::duration::zero();
+      do
+      {
+         body();
+         ++calls;
+         elapsed = clock_type::now() - start;
+      } while (elapsed < std::chrono::duration<double>(g_options.min_time));
+      return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(calls);
+   }
+
+   bool selected(std::string const& name)
+   {
+      return g_options.filter.empty() || std::string::npos != name.find(g_options.filter);
+   }
+
+   void report(std::string const& name, size_t tokens, double ns_per_token, size_t allocs, size_t peak_bytes)
+   {
+      std::printf("%-72s %9zu %12.2f %10zu %12zu\n", name.c_str(), tokens, ns_per_token, allocs, peak_bytes);
+   }
+
+   // parse: a fresh parser per parse
+   template<typename Parser>
+   void bench_parse(std::string const& name, command_line const& cmdl, int mode)
+   {
+      if (!selected(name))
+         return;
+
+      size_t allocs = 0, peak_bytes = 0;
+      {
+         allocation_scope scope;
+         Parser parser;
+         parser.add_params({ "jobs", "t" });
+         parser.parse(cmdl.argc(), cmdl.argv.data(), mode);
+         scope.measure(allocs, peak_bytes);
+      }
+
+      auto const ns = time_per_call([&]
+      {
+         Parser parser;
+         parser.add_params({ "jobs", "t" });
+         parser.parse(cmdl.argc(), cmdl.argv.data(), mode);
+         g_sink = parser.size();
+      });
+      report(name, cmdl.strings.size(), ns / static_cast<double>(cmdl.strings.size()), allocs, peak_bytes);
+   }
+
+   // re-parse: the same parser for every parse, after a first one
+   template<typename Parser>
+   void bench_reparse(std::string const& name, command_line const& cmdl, int mode)
+   {
+      if (!selected(name))
+         return;
+
+      Parser parser;
+      parser.add_params({ "jobs", "t" });
+      for (int i = 0; i < 3; ++i) // warm up: recycled strings grow to the longest value they are assigned
+         parser.reparse(cmdl.argc(), cmdl.argv.data(), mode);
+
+      size_t allocs = 0, peak_bytes = 0;
+      {
+         allocation_scope scope;
+         parser.reparse(cmdl.argc(), cmdl.argv.data(), mode);
+         scope.measure(allocs, peak_bytes);
+      }
+
+      auto const ns = time_per_call([&]
+      {
+         parser.reparse(cmdl.argc(), cmdl.argv.data(), mode);
+         g_sink = parser.size();
+      });
+      report(name, cmdl.strings.size(), ns / static_cast<double>(cmdl.strings.size()), allocs, peak_bytes);
+   }
+
+   // access: the lookups of a request handler, access() returns a value depending on the lookup
+   template<typename Parser, typename Access>
+   void bench_access(std::string const& name, Parser const& parser, Access&& access)
+   {
+      if (!selected(name))
+         return;
+
+      size_t allocs = 0, peak_bytes = 0;
+      {
+         allocation_scope scope;
+         g_sink = access(parser);
+         scope.measure(allocs, peak_bytes);
+      }
+
+      constexpr size_t batch = 1000;
+      auto const ns = time_per_call([&]
+      {
+         size_t sum = 0;
+         for (size_t i = 0; i < batch; ++i)
+            sum += access(parser);
+         g_sink = sum;
+      });
+      report(name, 1, ns / batch, allocs, peak_bytes);
+   }
+
+#if defined(ARGH_HAS_STRING_VIEW)
+   // visit: the args classified without building a parser
+   void bench_visit(std::string const& name, command_line const& cmdl, int mode)
+   {
+      if (!selected(name))
+         return;
+
+      struct counter
+      {
+         size_t events = 0;
+         void on_flag(std::string_view)                    { ++events; }
+         void on_param(std::string_view, std::string_view) { ++events; }
+         void on_positional(std::string_view)              { ++events; }
+      };
+      argh::param_names const registered{ "jobs", "t" };
+
+      size_t allocs = 0, peak_bytes = 0;
+      {
+         allocation_scope scope;
+         counter visitor;
+         argh::visit(cmdl.argc(), cmdl.argv.data(), mode, visitor, registered);
+         scope.measure(allocs, peak_bytes);
+      }
+
+      auto const ns = time_per_call([&]
+      {
+         counter visitor;
+         argh::visit(cmdl.argc(), cmdl.argv.data(), mode, visitor, registered);
+         g_sink = visitor.events;
+      });
+      report(name, cmdl.strings.size(), ns / static_cast<double>(cmdl.strings.size()), allocs, peak_bytes);
+   }
+#endif
+
+   std::string mode_name(int mode)
+   {
+      static char const* const names[] = { "FLAG", "PARAM", "NO_SPLIT", "MULTIFLAG", "RESPONSE_FILES", "DOUBLE_DASH", "UNIQUE_PREFIX" };
+      std::string name;
+      for (int bit = 0; bit < int(sizeof(names) / sizeof(names[0])); ++bit)
+      {
+         if (mode & (1 << bit))
+            name += (name.empty() ? "" : "|") + std::string(names[bit]);
+      }
+      return name;
+   }
+
+   //////////////////////////////////////////////////////////////////////////
+   // Benchmarks
+
+   void bench_sizes()
+   {
+      for (size_t tokens = 10; tokens <= g_options.max_tokens; tokens *= 10)
+      {
+         auto const cmdl = make_command_line(tokens);
+         int const mode = argh::parser::PREFER_FLAG_FOR_UNREG_OPTION;
+         bench_parse<argh::parser>("parse/parser", cmdl, mode);
+         bench_parse<argh::flat_parser>("parse/flat_parser", cmdl, mode);
+#if defined(ARGH_HAS_STRING_VIEW)
+         bench_parse<argh::view_parser>("parse/view_parser", cmdl, mode);
+         bench_parse<argh::flat_view_parser>("parse/flat_view_parser", cmdl, mode);
+         bench_parse<argh::pooled_parser>("parse/pooled_parser", cmdl, mode);
+#endif
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+         bench_parse<argh::pmr_parser>("parse/pmr_parser", cmdl, mode);
+#endif
+         bench_reparse<argh::parser>("reparse/parser", cmdl, mode);
+#if defined(ARGH_HAS_STRING_VIEW)
+         bench_visit("visit", cmdl, mode);
+         bench_reparse<argh::view_parser>("reparse/view_parser", cmdl, mode);
+#endif
+         bench_reparse<argh::flat_parser>("reparse/flat_parser", cmdl, mode);
+      }
+   }
+
+   void bench_modes()
+   {
+      auto const cmdl = make_command_line(std::min<size_t>(10000, g_options.max_tokens));
+      using mode = argh::parser;
+      for (int prefer : { mode::PREFER_FLAG_FOR_UNREG_OPTION, mode::PREFER_PARAM_FOR_UNREG_OPTION })
+      {
+         for (int others = 0; others < 32; ++others)
+         {
+            int combination = prefer;
+            combination |= (others & 1) ? mode::NO_SPLIT_ON_EQUALSIGN : 0;
+            combination |= (others & 2) ? mode::SINGLE_DASH_IS_MULTIFLAG : 0;
+            combination |= (others & 4) ? mode::EXPAND_RESPONSE_FILES : 0;
+            combination |= (others & 8) ? mode::DOUBLE_DASH_ENDS_OPTIONS : 0;
+            combination |= (others & 16) ? mode::MATCH_UNIQUE_PREFIX : 0;
+            bench_parse<argh::parser>("mode/" + mode_name(combination), cmdl, combination);
+         }
+      }
+   }
+
+   void bench_lookups()
+   {
+      auto const cmdl = make_command_line(std::min<size_t>(100, g_options.max_tokens));
+
+      argh::parser parser;
+      auto const jobs = parser.add_param("jobs");
+      auto const verbose = parser.add_flag("v");
+      parser.add_params({ "t", "threshold" }, "threshold");
+      parser.parse(cmdl.argc(), cmdl.argv.data());
+
+      bench_access("flag/name", parser, [](argh::parser const& p) { return size_t(p["v"]); });
+      bench_access("flag/dashed name", parser, [](argh::parser const& p) { return size_t(p["--flag-17"]); });
+      bench_access("flag/missing", parser, [](argh::parser const& p) { return size_t(p["missing"]); });
+      bench_access("flag/list", parser, [](argh::parser const& p) { return size_t(p[{ "-q", "-v" }]); });
+      bench_access("flag/key", parser, [verbose](argh::parser const& p) { return size_t(p[verbose]); });
+      bench_access("param/stream", parser, [](argh::parser const& p) { return p("jobs").str().size(); });
+      bench_access("param/get", parser, [](argh::parser const& p) { return size_t(p.get<int>("jobs").value_or(0)); });
+      bench_access("param/dashed get", parser, [](argh::parser const& p) { return size_t(p.get<int>("--jobs").value_or(0)); });
+      bench_access("param/key get", parser, [jobs](argh::parser const& p) { return size_t(p.get<int>(jobs).value_or(0)); });
+      bench_access("param/list get", parser, [](argh::parser const& p) { return size_t(p.get<int>({ "j", "jobs" }).value_or(0)); });
+      bench_access("alias/list get", parser, [](argh::parser const& p) { return size_t(p.get<double>({ "t", "threshold" }).value_or(0) * 100); });
+      bench_access("alias/get", parser, [](argh::parser const& p) { return size_t(p.get<double>("t").value_or(0) * 100); });
+      bench_access("alias/params", parser, [](argh::parser const& p) { return p.params("t").size(); });
+      bench_access("overlay/set get", parser, [](argh::parser const& p) { auto o = p.overlay(); o.set_param("jobs", "8"); return size_t(o.get<int>("jobs").value_or(0)); });
+      bench_access("overlay/base get", parser, [](argh::parser const& p) { auto o = p.overlay(); o.set_flag("v", false); return size_t(o.get<int>("jobs").value_or(0)); });
+      bench_access("positional/index", parser, [](argh::parser const& p) { return p[3].size(); });
+      bench_access("positional/get", parser, [](argh::parser const& p) { return size_t(p.get<int>(1).value_or(0)); });
+      bench_access("default/stream", parser, [](argh::parser const& p) { double d = 0; p("missing", 1.5) >> d; return size_t(d); });
+      bench_access("default/value_or", parser, [](argh::parser const& p) { return size_t(p.value_or("missing", 1.5)); });
+      bench_access("default/key value_or", parser, [jobs](argh::parser const& p) { return size_t(p.value_or(jobs, 1.5)); });
+
+#if defined(ARGH_HAS_STRING_VIEW)
+      auto const blob = parser.serialize();
+      argh::frozen_parser attached;
+      attached.attach(blob.data(), blob.size());
+      auto const frozen = parser.freeze();
+      bench_access("attached/flag", attached, [](argh::frozen_parser const& p) { return size_t(p["v"]); });
+      bench_access("attached/get", attached, [](argh::frozen_parser const& p) { return size_t(p.get<int>("jobs").value_or(0)); });
+      bench_access("frozen/flag", *frozen, [](argh::frozen_parser const& p) { return size_t(p["v"]); });
+      bench_access("frozen/missing", *frozen, [](argh::frozen_parser const& p) { return size_t(p["missing"]); });
+      bench_access("frozen/get", *frozen, [](argh::frozen_parser const& p) { return size_t(p.get<int>("jobs").value_or(0)); });
+#endif
+   }
+
+   void parse_options(int argc, char* argv[])
+   {
+      argh::parser cmdl(argc, argv);
+      g_options.max_tokens = cmdl.value_or("max-tokens", g_options.max_tokens);
+      g_options.min_time = cmdl.value_or("min-time", g_options.min_time);
+      g_options.filter = cmdl.value_or("filter", g_options.filter);
+   }
+}
+
+int main(int argc, char* argv[])
+{
+   parse_options(argc, argv);
+
+   std::printf("%-72s %9s %12s %10s %12s\n", "benchmark", "tokens", "ns/token", "allocs", "peak bytes");
+   bench_sizes();
+   bench_modes();
+   bench_lookups();
+   return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// Declarations of the argh parser types, without their definitions or the standard headers argh.h needs:
+// include this in headers that only pass parsers around by reference or pointer, and argh.h (or `import argh;`)
+// in the files that construct or use them.
+
+#include <string>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define ARGH_HAS_STRING_VIEW 1
+#include <string_view>
+#endif
+
+namespace argh
+{
+   class parser_base;
+   class key;
+   struct parse_stats;
+
+   struct node_storage;
+   struct flat_storage;
+   template<typename Base = node_storage>
+   struct pooled_storage;
+
+   template<typename String, typename Storage = node_storage>
+   class basic_parser;
+
+   using parser = basic_parser<std::string>;
+   using flat_parser = basic_parser<std::string, flat_storage>;
+
+   class incremental_parser;
+   template<typename Parser>
+   class basic_overlay;
+
+#if defined(ARGH_HAS_STRING_VIEW)
+   // Zero-copy variant: args, flags, params and positional args all refer back into the parsed argv,
+   // which must outlive the parser.
+   using view_parser = basic_parser<std::string_view>;
+   using flat_view_parser = basic_parser<std::string_view, flat_storage>;
+
+   // Owning variant of the above: the args are copied into one buffer per parse, that everything refers into,
+   // so argv (or the strings parsed) need not outlive the parser. It can be moved, but not copied: the views of a copy
+   // would still refer into the buffer of the original.
+   using pooled_parser = basic_parser<std::string_view, pooled_storage<>>;
+   using flat_pooled_parser = basic_parser<std::string_view, pooled_storage<flat_storage>>;
+
+   class frozen_parser;
+   class param_names;
+   class parsed_batch;
+   template<typename Schema>
+   class static_parser;
+#endif
+}
@@ -1,4 +1,9 @@
 #include "argh.h"
+#include "wargh.h"
+#include <cstdio>
+#include <fstream>
+#include <atomic>
+#include <thread>
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
@@ -120,6 +125,26 @@ TEST_CASE("Test negative numbers are not options")
     CHECK(0 == cmdl.flags().size());
 }
 
+TEST_CASE("Test number detection matches istream")
+{
+    const char* numbers[] = { "-5", "-.5", "-5.", "-1.e3", "-1E+3", "-0x10", "-12abc", "-1e5x" };
+    const char* options[] = { "-", "--5", "-.", "-e5", "-.e5", "-1e", "-1e+", "-x1", "-inf" };
+    for (auto arg : numbers)
+    {
+        const char* argv[] = { arg, nullptr };
+        parser cmdl(argv);
+        CHECK(1 == cmdl.pos_args().size());
+        CHECK(0 == cmdl.flags().size());
+    }
+    for (auto arg : options)
+    {
+        const char* argv[] = { arg, "1", nullptr };
+        parser cmdl(argv, parser::PREFER_PARAM_FOR_UNREG_OPTION);
+        CHECK(0 == cmdl.pos_args().size());
+        CHECK(1 == cmdl.params().size());
+    }
+}
+
 TEST_CASE("Test failed istream access")
 {
     const char* argv[] = { "-string", "Hello" };
@@ -882,4 +907,1850 @@ TEST_CASE("Test parsing multiple with add_param")
 
     CHECK(cmdl({"a", "b", "c"}));
     CHECK(fixture == cmdl({"a"}).str());
-}
\ No newline at end of file
+}
+#if defined(ARGH_HAS_STRING_VIEW)
+TEST_CASE("Test view_parser refers into argv")
+{
+    const char* argv[] = { "0", "-a", "1", "--b=2", "-xvf", "3", nullptr };
+    int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+    view_parser cmdl;
+    cmdl.add_param("f");
+    cmdl.parse(argc, argv, parser::SINGLE_DASH_IS_MULTIFLAG);
+
+    CHECK(2 == cmdl.pos_args().size());
+    CHECK(cmdl[0] == "0");
+    CHECK(cmdl[1] == "1");
+    CHECK(cmdl[2].empty());
+    CHECK(cmdl[0].data() == argv[0]);
+    CHECK(cmdl[1].data() == argv[2]);
+
+    CHECK(cmdl["a"]);
+    CHECK(cmdl["-x"]);
+    CHECK(cmdl[{ "q", "v" }]);
+    CHECK(!cmdl["xvf"]);
+    CHECK(3 == cmdl.flags().size());
+    CHECK(cmdl.flags().find("x")->data() == argv[4] + 1);
+
+    CHECK(cmdl("b").str() == "2");
+    CHECK(cmdl.params().find("b")->first.data() == argv[3] + 2);
+    CHECK(cmdl.params().find("b")->second.data() == argv[3] + 4);
+    CHECK(cmdl("f").str() == "3");
+    CHECK(cmdl.params().find("f")->second.data() == argv[5]);
+
+    int val = -1;
+    CHECK((cmdl({ "-f", "--file" }) >> val));
+    CHECK(3 == val);
+    CHECK((cmdl("missing", 7) >> val));
+    CHECK(7 == val);
+    CHECK((cmdl(1) >> val));
+    CHECK(1 == val);
+    CHECK(!cmdl(5));
+}
+
+TEST_CASE("Test view_parser matches parser")
+{
+    const char* argv[] = { "-d", "-f", "123", "-g", "456", "-e", "--foo=1", "--foo=2", "-1.5", nullptr };
+    int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+    for (int mode : { int(parser::PREFER_FLAG_FOR_UNREG_OPTION), int(parser::PREFER_PARAM_FOR_UNREG_OPTION) })
+    {
+        parser owning({ "g" });
+        view_parser viewing({ "g" });
+        owning.parse(argc, argv, mode);
+        viewing.parse(argc, argv, mode);
+
+        CHECK(std::vector<std::string>(viewing.begin(), viewing.end()) == owning.pos_args());
+        CHECK(std::multiset<std::string>(viewing.flags().begin(), viewing.flags().end()) == owning.flags());
+        CHECK(std::multimap<std::string, std::string>(viewing.params().begin(), viewing.params().end()) == owning.params());
+        CHECK(2 == viewing.params("foo").size());
+    }
+}
+#endif
+
+struct point
+{
+    int x = 0;
+    int y = 0;
+};
+
+std::istream& operator>>(std::istream& is, point& p)
+{
+    char comma = 0;
+    return is >> p.x >> comma >> p.y;
+}
+
+TEST_CASE("Test typed get<T>()")
+{
+    const char* argv[] = { "app", "42", "-i=-17", "--big=99999999999", "-u=-1", "-d=-2.5e3", "-b=true", "-z=0",
+                           "-bad=12x", "-p=3,4", "-s=hello world", "--empty=", nullptr };
+    parser cmdl(argv);
+
+    CHECK(cmdl.get<int>("i").has_value());
+    CHECK(-17 == *cmdl.get<int>("i"));
+    CHECK(-17 == cmdl.get<long long>("--i").value());
+    CHECK(99999999999LL == *cmdl.get<long long>("big"));
+    CHECK(get_status::BAD_CONVERSION == cmdl.get<int>("big").status());
+    CHECK(!cmdl.get<unsigned>("u"));
+    CHECK(-1 == *cmdl.get<short>("u"));
+    CHECK(-2500.0 == *cmdl.get<double>("d"));
+    CHECK(-2500.0f == *cmdl.get<float>("d"));
+    CHECK(get_status::BAD_CONVERSION == cmdl.get<int>("d").status());
+    CHECK(*cmdl.get<bool>("b"));
+    CHECK(!*cmdl.get<bool>("z"));
+    CHECK(!cmdl.get<bool>("i"));
+    CHECK(get_status::BAD_CONVERSION == cmdl.get<int>("bad").status());
+    CHECK(get_status::BAD_CONVERSION == cmdl.get<double>("bad").status());
+    CHECK(get_status::BAD_CONVERSION == cmdl.get<int>("empty").status());
+    CHECK(get_status::MISSING == cmdl.get<int>("missing").status());
+    CHECK(5 == cmdl.get<int>("missing").value_or(5));
+    CHECK(-17 == cmdl.get<int>("i").value_or(5));
+
+    CHECK("hello world" == *cmdl.get<std::string>("s"));
+    CHECK(cmdl.get<std::string>("empty").value().empty());
+    CHECK(3 == cmdl.get<point>("p")->x);
+    CHECK(4 == cmdl.get<point>("p")->y);
+
+    CHECK(-17 == *cmdl.get<int>({ "x", "i", "big" }));
+    CHECK(get_status::MISSING == cmdl.get<int>({ "x", "y" }).status());
+
+    CHECK("app" == *cmdl.get<std::string>(0));
+    CHECK(42 == *cmdl.get<int>(1));
+    CHECK(get_status::MISSING == cmdl.get<int>(2).status());
+}
+
+#if defined(ARGH_HAS_STRING_VIEW)
+TEST_CASE("Test typed get<T>() on view_parser")
+{
+    const char* argv[] = { "-n=12", "-d=0.25", "--name=value", nullptr };
+    view_parser cmdl(argv);
+    CHECK(12 == *cmdl.get<int>("n"));
+    CHECK(0.25 == *cmdl.get<double>("d"));
+    CHECK(argv[2] + 7 == cmdl.get<std::string_view>("name")->data());
+}
+#endif
+
+TEST_CASE("Test flat_parser matches parser")
+{
+    const char* argv[] = { "app", "-d", "-f", "123", "--foo=3", "-g", "456", "--foo=1", "-xvf", "-e", "--foo=2", "-b", "-b", "-1.5", nullptr };
+    int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+    int modes[] = {
+        parser::PREFER_FLAG_FOR_UNREG_OPTION,
+        parser::PREFER_PARAM_FOR_UNREG_OPTION,
+        parser::PREFER_PARAM_FOR_UNREG_OPTION | parser::SINGLE_DASH_IS_MULTIFLAG,
+        parser::NO_SPLIT_ON_EQUALSIGN,
+    };
+    for (int mode : modes)
+    {
+        parser nodes({ "g" });
+        flat_parser flat({ "g" });
+        nodes.parse(argc, argv, mode);
+        flat.parse(argc, argv, mode);
+
+        CHECK(flat.pos_args() == nodes.pos_args());
+        CHECK(std::multiset<std::string>(flat.flags().begin(), flat.flags().end()) == nodes.flags());
+        CHECK(flat.params().size() == nodes.params().size());
+        CHECK(std::multimap<std::string, std::string>(flat.params().begin(), flat.params().end()) == nodes.params());
+        CHECK(flat["b"] == nodes["b"]);
+        CHECK(flat.flags().count("b") == nodes.flags().count("b"));
+        CHECK(flat("g").str() == nodes("g").str());
+        CHECK(flat({ "x", "foo" }).str() == nodes({ "x", "foo" }).str());
+    }
+
+    // equal keys keep their order of appearance
+    flat_parser flat(argc, argv);
+    auto foos = flat.params("foo");
+    CHECK(3 == foos.size());
+    std::vector<std::string> values;
+    for (auto const& param : foos)
+        values.push_back(param.second);
+    CHECK(std::vector<std::string>{ "3", "1", "2" } == values);
+    CHECK("3" == flat("foo").str());
+
+    // many options out of order: appended during the parse, then sorted once
+    std::vector<std::string> args = { "app" };
+    for (int i = 20000; 0 < i; --i)
+    {
+        args.push_back("--p" + std::to_string(i % 100) + "=" + std::to_string(i));
+        args.push_back("--f" + std::to_string(i % 50));
+    }
+    parser many_nodes;
+    many_nodes.parse(args.begin(), args.end());
+    flat_parser many_flat;
+    many_flat.parse(args.begin(), args.end());
+    CHECK(std::multiset<std::string>(many_flat.flags().begin(), many_flat.flags().end()) == many_nodes.flags());
+    CHECK(std::multimap<std::string, std::string>(many_flat.params().begin(), many_flat.params().end()) == many_nodes.params());
+    CHECK(std::is_sorted(many_flat.flags().begin(), many_flat.flags().end()));
+    CHECK("20000" == many_flat("p0").str());
+    CHECK("19900" == std::next(many_flat.params("p0").begin())->second);
+}
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+// fails on any allocation outside of the arena, by making the default resource throw
+struct no_default_resource
+{
+    no_default_resource() : previous_(std::pmr::set_default_resource(std::pmr::null_memory_resource())) {}
+    ~no_default_resource() { std::pmr::set_default_resource(previous_); }
+    std::pmr::memory_resource* previous_;
+};
+
+TEST_CASE("Test pmr_parser allocates from the given resource")
+{
+    const char* argv[] = { "a-positional-arg-longer-than-sso", "--a-long-parameter-name=a-long-parameter-value",
+                           "--another-long-parameter-name", "another-long-parameter-value", "-xvf", "--some-long-flag-name", nullptr };
+    int argc = sizeof(argv) / sizeof(argv[0]) - 1;
+
+    char buffer[8192];
+    for (int storage = 0; storage < 2; ++storage)
+    {
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+        auto check = [&](auto& cmdl)
+        {
+            {
+                no_default_resource guard;
+                cmdl.add_param("another-long-parameter-name");
+                cmdl.parse(argc, argv, parser::SINGLE_DASH_IS_MULTIFLAG);
+            }
+
+            CHECK(1 == cmdl.size());
+            CHECK(cmdl[0] == argv[0]);
+            CHECK(cmdl["x"]);
+            CHECK(cmdl["f"]);
+            CHECK(cmdl["some-long-flag-name"]);
+            CHECK(4 == cmdl.flags().size());
+            CHECK(2 == cmdl.params().size());
+            CHECK("another-long-parameter-value" == cmdl("another-long-parameter-name").str());
+            CHECK(cmdl.pos_args().get_allocator().resource() == &arena);
+            CHECK(cmdl.pos_args()[0].get_allocator().resource() == &arena);
+            CHECK(cmdl.params().begin()->first.get_allocator().resource() == &arena);
+            CHECK(cmdl.params().begin()->second.get_allocator().resource() == &arena);
+        };
+
+        if (0 == storage)
+        {
+            pmr_parser cmdl(&arena);
+            check(cmdl);
+        }
+        else
+        {
+            pmr_flat_parser cmdl(&arena);
+            check(cmdl);
+        }
+    }
+}
+#endif
+
+TEST_CASE("Test reparse(...) gives the same results as parse(...)")
+{
+    const char* argv_1[] = { "-a", "b", "-c=10", "d", "-f", "--long-parameter-name", "a-long-parameter-value", "-xvf" };
+    const char* argv_2[] = { "-a", "b", "-d=c" };
+    int argc_1 = sizeof(argv_1) / sizeof(argv_1[0]);
+    int argc_2 = sizeof(argv_2) / sizeof(argv_2[0]);
+
+    parser cmdl;
+    cmdl.add_param("long-parameter-name");
+    for (int round = 0; round < 3; ++round)
+    {
+        cmdl.reparse(argc_1, argv_1, parser::SINGLE_DASH_IS_MULTIFLAG);
+        CHECK(std::multiset<std::string>{ "a", "f", "x", "v", "f" } == cmdl.flags());
+        CHECK(std::vector<std::string>{ "b", "d" } == cmdl.pos_args());
+        CHECK(std::multimap<std::string, std::string>{ { "c", "10" }, { "long-parameter-name", "a-long-parameter-value" } } == cmdl.params());
+
+        cmdl.reparse(argc_2, argv_2);
+        CHECK(std::multiset<std::string>{ "a" } == cmdl.flags());
+        CHECK(std::vector<std::string>{ "b" } == cmdl.pos_args());
+        CHECK(std::multimap<std::string, std::string>{ { "d", "c" } } == cmdl.params());
+    }
+
+    flat_parser flat;
+    flat.reparse(argc_1, argv_1);
+    flat.reparse(argc_2, argv_2);
+    CHECK(1 == flat.flags().size());
+    CHECK(flat["a"]);
+    CHECK(std::vector<std::string>{ "b" } == flat.pos_args());
+    CHECK("c" == flat("d").str());
+}
+
+TEST_CASE("Test reparse(...) reuses string storage")
+{
+    const char* argv[] = { "a-positional-arg-longer-than-sso", "--a-long-parameter-name=a-long-parameter-value", nullptr };
+
+    parser cmdl(argv);
+    cmdl.reparse(argv);
+    auto pos_arg_data = cmdl[0].data();
+    auto param_data = cmdl.params().begin()->second.data();
+    cmdl.reparse(argv);
+    CHECK(pos_arg_data == cmdl[0].data());
+#if defined(ARGH_HAS_STRING_VIEW)
+    CHECK(param_data == cmdl.params().begin()->second.data()); // tree nodes are only recycled from C++17
+#endif
+    (void)param_data;
+}
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+TEST_CASE("Test reparse(...) does not allocate in steady state")
+{
+    const char* argv_1[] = { "a-positional-arg-longer-than-sso", "--a-long-parameter-name=a-long-parameter-value",
+                             "--another-long-parameter-name", "another-long-parameter-value", "-xvf", "--some-long-flag-name", nullptr };
+    const char* argv_2[] = { "--another-long-parameter-name", "another-long-parameter-value", "-xfv", "another-positional-arg", nullptr };
+
+    counting_resource resource;
+    auto check = [&](auto& cmdl)
+    {
+        cmdl.add_param("another-long-parameter-name");
+        for (int i = 0; i < 3; ++i) // warm up: recycled strings grow to the longest value they are assigned
+        {
+            cmdl.reparse(argv_1, parser::SINGLE_DASH_IS_MULTIFLAG);
+            cmdl.reparse(argv_2, parser::SINGLE_DASH_IS_MULTIFLAG);
+        }
+
+        auto const allocations = resource.allocations();
+        for (int i = 0; i < 10; ++i)
+        {
+            cmdl.reparse(argv_1, parser::SINGLE_DASH_IS_MULTIFLAG);
+            cmdl.reparse(argv_2, parser::SINGLE_DASH_IS_MULTIFLAG);
+        }
+        CHECK(allocations == resource.allocations());
+        CHECK(std::pmr::vector<std::pmr::string>{ "another-positional-arg" } == cmdl.pos_args());
+        CHECK(4 == cmdl.flags().size() + cmdl.params().size());
+    };
+
+    pmr_parser nodes(&resource);
+    check(nodes);
+    pmr_flat_parser flat(&resource);
+    check(flat);
+}
+#endif
+
+#if defined(ARGH_HAS_STRING_VIEW)
+struct tool_schema
+{
+    static constexpr static_option options[] = {
+        static_param("o", "output"),
+        static_param("-j", "--jobs"),
+        static_flag("v", "verbose"),
+        static_flag("x"),
+    };
+};
+
+TEST_CASE("Test static_parser")
+{
+    using tool_parser = static_parser<tool_schema>;
+    constexpr tool_parser::key output("output");
+    constexpr tool_parser::key jobs("j");
+    constexpr tool_parser::key verbose("--verbose");
+    static_assert(output.index() == tool_parser::key("o").index(), "aliases are the same option");
+    static_assert(jobs.index() != verbose.index(), "options are distinct");
+
+    const char* argv[] = { "app", "-o", "out.txt", "--jobs", "8", "-v", "--other", "free", "--level=3", "-x", "last", nullptr };
+    tool_parser cmdl(argv);
+
+    CHECK("out.txt" == cmdl(output).str());
+    CHECK(argv[2] == cmdl.get<std::string_view>(output)->data());
+    CHECK(8 == *cmdl.get<int>(jobs));
+    CHECK(8 == *cmdl.get<int>("--j"));
+    CHECK(cmdl[verbose]);
+    CHECK(cmdl["v"]);
+    CHECK(cmdl["x"]);
+    CHECK(!cmdl[output]);
+    CHECK(!cmdl["other"]);
+    CHECK(!cmdl("missing"));
+    CHECK(get_status::MISSING == cmdl.get<int>("nope").status());
+
+    // unregistered options follow the mode, as with parser
+    CHECK(1 == cmdl.unknown_flags().size());
+    CHECK("other" == cmdl.unknown_flags()[0]);
+    CHECK(1 == cmdl.unknown_params().size());
+    CHECK("level" == cmdl.unknown_params()[0].first);
+    CHECK("3" == cmdl.unknown_params()[0].second);
+
+    CHECK(3 == cmdl.size());
+    CHECK("app" == cmdl[0]);
+    CHECK("free" == cmdl[1]);
+    CHECK("last" == cmdl[2]);
+    CHECK(cmdl[3].empty());
+
+    // same results as parser with the same registrations
+    parser reference({ "o", "output", "j", "jobs" });
+    reference.parse(argv);
+    CHECK(reference.size() == cmdl.size());
+    CHECK(reference["other"]);
+    CHECK(reference["verbose"] != reference["v"]);
+    CHECK("3" == reference("level").str());
+
+    cmdl.parse(argv, parser_base::PREFER_PARAM_FOR_UNREG_OPTION);
+    CHECK(cmdl.unknown_flags().empty());
+    CHECK(2 == cmdl.unknown_params().size());
+    CHECK("free" == cmdl.unknown_params()[0].second);
+    CHECK(2 == cmdl.size());
+
+    const char* multi[] = { "-vxo", "out", nullptr };
+    cmdl.parse(multi, parser_base::SINGLE_DASH_IS_MULTIFLAG);
+    CHECK(cmdl[verbose]);
+    CHECK(cmdl["x"]);
+    CHECK("out" == cmdl(output).str());
+    CHECK(0 == cmdl.size());
+}
+
+// a schema of many options, as in large tools: "o042" and "opt-042" name option 42
+template<size_t I>
+struct generated_names
+{
+    static constexpr char short_name[] = { 'o', char('0' + I / 100), char('0' + I / 10 % 10), char('0' + I % 10), '\0' };
+    static constexpr char long_name[] = { 'o', 'p', 't', '-', char('0' + I / 100), char('0' + I / 10 % 10), char('0' + I % 10), '\0' };
+};
+
+template<typename Sequence>
+struct generated_schema;
+
+template<size_t... I>
+struct generated_schema<std::index_sequence<I...>>
+{
+    static constexpr static_option options[] = { static_param(generated_names<I>::short_name, generated_names<I>::long_name)... };
+};
+
+TEST_CASE("Test static_parser with a large schema")
+{
+    using large_parser = static_parser<generated_schema<std::make_index_sequence<500>>>;
+    constexpr large_parser::key last("opt-499");
+    static_assert(last.index() == large_parser::key("o499").index(), "aliases are the same option");
+    static_assert(499 == last.index(), "options keep their index");
+
+    const char* argv[] = { "app", "--o000", "1", "--opt-123", "2", "-o499=3", "--o500", "free", nullptr };
+    large_parser cmdl(argv);
+    CHECK(1 == *cmdl.get<int>("opt-000"));
+    CHECK(2 == *cmdl.get<int>("o123"));
+    CHECK(3 == *cmdl.get<int>(last));
+    CHECK(!cmdl("o250"));
+    CHECK(1 == cmdl.unknown_flags().size());
+    CHECK(2 == cmdl.size());
+}
+#endif
+
+TEST_CASE("Test parse_string(...) splits like a shell")
+{
+    parser cmdl;
+    CHECK(cmdl.parse_string("app  -v --name 'a b'\t\"c \\\"d\\\" \\e\" x\\ y la'te'r\"al\" '' --sum=1\\\n2", parser::PREFER_PARAM_FOR_UNREG_OPTION));
+    CHECK(cmdl["v"]);
+    CHECK("a b" == cmdl("name").str());
+    CHECK(5 == cmdl.size());
+    CHECK("app" == cmdl[0]);
+    CHECK("c \"d\" \\e" == cmdl[1]);
+    CHECK("x y" == cmdl[2]);
+    CHECK("lateral" == cmdl[3]);
+    CHECK(cmdl[4].empty());
+    CHECK("12" == cmdl("sum").str());
+
+    // same results as parse(...) of the parts
+    const char* argv[] = { "app", "-v", "--name", "a b", "c \"d\" \\e", "x y", "lateral", "", "--sum=12", nullptr };
+    parser reference(argv, parser::PREFER_PARAM_FOR_UNREG_OPTION);
+    CHECK(reference.flags() == cmdl.flags());
+    CHECK(reference.params() == cmdl.params());
+    CHECK(reference.pos_args() == cmdl.pos_args());
+
+    CHECK(cmdl.parse_string(" \n "));
+    CHECK(0 == cmdl.size());
+    CHECK(cmdl.flags().empty());
+
+    CHECK(!cmdl.parse_string("-f 'not closed", parser::PREFER_PARAM_FOR_UNREG_OPTION));
+    CHECK("not closed" == cmdl("f").str());
+    CHECK(!cmdl.parse_string("\"a\\"));
+    CHECK("a\\" == cmdl[0]);
+    CHECK(cmdl.parse_string("end\\"));
+    CHECK("end\\" == cmdl[0]);
+}
+
+TEST_CASE("Test parse_string(...) on long lines")
+{
+    // puts quotes, escapes and separators at every offset of the 8-char blocks scanned at once
+    std::string line;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 200; ++i)
+    {
+        std::string part(static_cast<size_t>(1 + i % 19), 'a' + i % 26);
+        switch (i % 4)
+        {
+        case 0: line += part; expected.push_back(part); break;
+        case 1: line += "\"" + part + "\""; expected.push_back(part); break;
+        case 2: line += part + "\\ " + part; expected.push_back(part + " " + part); break;
+        case 3: line += "'" + part + "'" + part; expected.push_back(part + part); break;
+        }
+        line += std::string(static_cast<size_t>(1 + i % 3), ' ');
+    }
+
+    parser cmdl;
+    CHECK(cmdl.parse_string(line));
+    CHECK(expected == cmdl.pos_args());
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    view_parser view;
+    CHECK(view.parse_string(line));
+    REQUIRE(expected.size() == view.size());
+    CHECK(std::equal(expected.begin(), expected.end(), view.begin()));
+#endif
+}
+
+struct temp_file
+{
+    std::string path;
+    temp_file(std::string file_path, std::string const& contents) : path(std::move(file_path))
+    {
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+    ~temp_file() { std::remove(path.c_str()); }
+};
+
+TEST_CASE("Test EXPAND_RESPONSE_FILES")
+{
+    temp_file inner("argh_test_inner.rsp", "--level 3 \"quoted arg\" @argh_test_outer.rsp");
+    temp_file outer("argh_test_outer.rsp", "-v\n--out 'a b.txt'\n@argh_test_inner.rsp\n@argh_test_missing.rsp tail\n");
+    temp_file empty("argh_test_empty.rsp", "");
+
+    const char* argv[] = { "app", "@argh_test_outer.rsp", "last", "@argh_test_empty.rsp", "@", nullptr };
+    int const mode = parser::PREFER_PARAM_FOR_UNREG_OPTION | parser::EXPAND_RESPONSE_FILES;
+
+    parser cmdl(argv, mode);
+    CHECK(cmdl["v"]);
+    CHECK("a b.txt" == cmdl("out").str());
+    CHECK("3" == cmdl("level").str());
+    // the outer file is not expanded again inside itself, and a missing file is kept as it is
+    CHECK((std::vector<std::string>{ "app", "quoted arg", "@argh_test_outer.rsp", "@argh_test_missing.rsp", "tail", "last", "@" }) == cmdl.pos_args());
+
+    // without the mode, @ args are plain args
+    cmdl.parse(argv, parser::PREFER_PARAM_FOR_UNREG_OPTION);
+    CHECK("@argh_test_outer.rsp" == cmdl[1]);
+
+    // also from a string, and through reparse
+    cmdl.parse_string("app @argh_test_inner.rsp", mode);
+    CHECK("3" == cmdl("level").str());
+    CHECK(cmdl["v"]);
+    CHECK("quoted arg" == cmdl[1]);
+    CHECK("@argh_test_inner.rsp" == cmdl[2]);
+    cmdl.reparse(argv, mode);
+    CHECK("a b.txt" == cmdl("out").str());
+    CHECK(7 == cmdl.size());
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    view_parser view(argv, mode);
+    CHECK("a b.txt" == view("out").str());
+    CHECK(cmdl.pos_args().size() == view.size());
+    CHECK(std::equal(cmdl.begin(), cmdl.end(), view.begin()));
+#endif
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+    // reparsing reuses the expanded args, and the strings they own
+    temp_file longer("argh_test_longer.rsp", "--a-long-parameter-name a-long-parameter-value a-positional-arg-longer-than-sso");
+    const char* long_argv[] = { "app", "@argh_test_longer.rsp", "another-positional-arg-longer-than-sso", nullptr };
+    counting_resource resource;
+    pmr_parser pooled(&resource);
+    for (int i = 0; i < 4; ++i) // warm up: the strings swap between args_ and the expanded args while they grow
+    {
+        pooled.reparse(long_argv, mode);
+        pooled.reparse(argv, mode);
+    }
+    auto const allocations = resource.allocations();
+    for (int i = 0; i < 10; ++i)
+    {
+        pooled.reparse(long_argv, mode);
+        pooled.reparse(argv, mode);
+    }
+    CHECK(allocations == resource.allocations());
+    CHECK("a b.txt" == pooled("out").str());
+    pooled.reparse(long_argv, mode);
+    CHECK("a-long-parameter-value" == pooled("a-long-parameter-name").str());
+    CHECK(std::pmr::vector<std::pmr::string>{ "app", "a-positional-arg-longer-than-sso", "another-positional-arg-longer-than-sso" } == pooled.pos_args());
+#endif
+}
+
+#if defined(ARGH_HAS_STRING_VIEW)
+TEST_CASE("Test parse_batch(...)")
+{
+    const char* a[] = { "app", "-v", "--out", "x.txt", "--jobs=4", "free", nullptr };
+    const char* b[] = { "tool", "-z", "-a", "--n=1", "--n=2", nullptr };
+    const char* c[] = { nullptr };
+    std::vector<const char* const*> argvs;
+    for (int i = 0; i < 1000; ++i)
+        argvs.push_back(0 == i % 3 ? a : 1 == i % 3 ? b : c);
+
+    auto const batch = parse_batch(argvs, parser::PREFER_FLAG_FOR_UNREG_OPTION, { "out" });
+    REQUIRE(argvs.size() == batch.size());
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        parser reference({ "out" });
+        reference.parse(argvs[i]);
+        auto const line = batch[i];
+        REQUIRE(reference.size() == line.size());
+        CHECK(std::equal(reference.begin(), reference.end(), line.begin()));
+        CHECK(std::equal(reference.flags().begin(), reference.flags().end(), line.flags().begin()));
+        CHECK(reference.params().size() == static_cast<size_t>(line.params().size()));
+        CHECK(std::equal(reference.params().begin(), reference.params().end(), line.params().begin(),
+            [](std::pair<const std::string, std::string> const& lhs, parsed_batch::param_type const& rhs) { return lhs.first == rhs.first && lhs.second == rhs.second; }));
+    }
+
+    auto const first = batch[0];
+    CHECK(first["v"]);
+    CHECK(!first["z"]);
+    CHECK("x.txt" == first("--out").str());
+    CHECK(4 == *first.get<int>("jobs"));
+    CHECK("free" == first[1]);
+    CHECK(a[3] == first.params("out").begin()->second.data());
+    CHECK(2 == batch[1].params("n").size());
+    CHECK("1" == batch[1]("n").str());
+    CHECK(0 == batch[2].size());
+    CHECK(get_status::MISSING == batch[2].get<int>(0).status());
+}
+
+TEST_CASE("Test parse_batch(...) of strings with an executor")
+{
+    std::vector<std::string> lines;
+    for (int i = 0; i < 600; ++i)
+        lines.push_back("app --id " + std::to_string(i) + " 'arg " + std::to_string(i) + "'");
+
+    size_t tasks = 0;
+    auto sequential = [&](size_t task_count, auto const& task)
+    {
+        for (size_t t = 0; t < task_count; ++t, ++tasks)
+            task(t);
+    };
+    auto const batch = parse_batch(lines, parser::PREFER_PARAM_FOR_UNREG_OPTION, {}, sequential);
+    CHECK(3 == tasks);
+    REQUIRE(600 == batch.size());
+    for (int i = 0; i < 600; ++i)
+    {
+        CHECK(i == *batch[static_cast<size_t>(i)].get<int>("id"));
+        CHECK("arg " + std::to_string(i) == batch[static_cast<size_t>(i)][1]);
+    }
+
+    CHECK(0 == parse_batch(std::vector<std::string>()).size());
+    CHECK(600 == parse_batch(lines, parser::PREFER_PARAM_FOR_UNREG_OPTION, {}, serial_executor()).size());
+#if defined(ARGH_ENABLE_THREADS)
+    CHECK(600 == parse_batch(lines, parser::PREFER_PARAM_FOR_UNREG_OPTION, {}, thread_executor{ 4 }).size());
+#endif
+}
+
+#if defined(ARGH_ENABLE_THREADS)
+TEST_CASE("Test thread_executor rethrows task exceptions")
+{
+    for (unsigned threads : { 1u, 4u })
+    {
+        std::vector<std::atomic<int>> runs(1000);
+        auto const throwing = [&](size_t i)
+        {
+            ++runs[i];
+            if (0 == i % 100)
+                throw std::runtime_error("task " + std::to_string(i));
+        };
+        CHECK_THROWS_AS(thread_executor{ threads }(runs.size(), throwing), std::runtime_error);
+        CHECK(std::all_of(runs.begin(), runs.end(), [](std::atomic<int> const& n) { return n <= 1; }));
+        CHECK(1 == runs[0]);
+    }
+
+    std::atomic<size_t> done(0);
+    thread_executor{ 4 }(100, [&](size_t) { ++done; });
+    CHECK(100 == done);
+}
+#endif
+#endif
+
+TEST_CASE("Test wparser")
+{
+    const wchar_t* argv[] = { L"app", L"-v", L"--name", L"\u00e9t\u00e9", L"--pi=3.14", L"-n=-12", L"-xz", L"free", nullptr };
+    wparser cmdl(argv, wparser::SINGLE_DASH_IS_MULTIFLAG);
+    cmdl.add_param(L"name");
+    cmdl.parse(argv, wparser::SINGLE_DASH_IS_MULTIFLAG);
+
+    CHECK(cmdl[L"v"]);
+    CHECK(cmdl[{ L"q", L"x" }]);
+    CHECK(cmdl[L"z"]);
+    CHECK(L"\u00e9t\u00e9" == cmdl(L"name").str());
+    CHECK(L"app" == cmdl[0]);
+    CHECK(L"free" == cmdl[1]);
+
+    double pi = 0;
+    CHECK(!!(cmdl(L"pi") >> pi));
+    CHECK(3.14 == pi);
+    CHECK(3.14 == *cmdl.get<double>(L"pi"));
+    CHECK(-12 == *cmdl.get<int>(L"n"));
+    CHECK(get_status::BAD_CONVERSION == cmdl.get<double>(L"name").status());
+    CHECK(L"\u00e9t\u00e9" == *cmdl.get<std::wstring>({ L"missing", L"name" }));
+    int def = 0;
+    CHECK(!!(cmdl(L"missing", 7) >> def));
+    CHECK(7 == def);
+
+    CHECK(cmdl.parse_string(L"tool '\u00e0 b' --k=v"));
+    CHECK(L"\u00e0 b" == cmdl[1]);
+    CHECK(L"v" == cmdl(L"k").str());
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    wview_parser view(argv);
+    CHECK(argv[3] == view[1].data());
+    CHECK(-12 == *view.get<int>(L"n"));
+#endif
+}
+
+TEST_CASE("Test DOUBLE_DASH_ENDS_OPTIONS")
+{
+    const char* argv[] = { "app", "-v", "--", "-x", "--y=1", "free", nullptr };
+
+    parser plain(argv);
+    CHECK(plain["--"]);
+    CHECK(plain["x"]);
+    CHECK(0 == plain.remainder().size());
+
+    parser cmdl(argv, parser::DOUBLE_DASH_ENDS_OPTIONS);
+    CHECK(cmdl["v"]);
+    CHECK(!cmdl["--"]);
+    CHECK(!cmdl["x"]);
+    CHECK(1 == cmdl.size());
+    REQUIRE(3 == cmdl.remainder().size());
+    CHECK((std::vector<std::string>{ "-x", "--y=1", "free" }) == std::vector<std::string>(cmdl.remainder().begin(), cmdl.remainder().end()));
+
+    const char* trailing[] = { "app", "--", nullptr };
+    cmdl.parse(trailing, parser::DOUBLE_DASH_ENDS_OPTIONS);
+    CHECK(cmdl.flags().empty());
+    CHECK(0 == cmdl.remainder().size());
+}
+
+TEST_CASE("Test subcommands")
+{
+    const char* argv[] = { "tool", "-v", "--jobs", "4", "build", "--release", "target", "run", "-x", nullptr };
+
+    parser cmdl({ "jobs" });
+    cmdl.add_subcommands({ "build", "run" });
+    cmdl.parse(argv);
+    CHECK(cmdl["v"]);
+    CHECK("4" == cmdl("jobs").str());
+    CHECK(!cmdl["release"]);
+    CHECK(1 == cmdl.size());
+    REQUIRE(5 == cmdl.remainder().size());
+    CHECK("build" == *cmdl.remainder().begin());
+
+    // the subcommand parses its own args, its name is its first positional arg
+    parser build;
+    build.add_subcommand("run");
+    build.parse(cmdl.remainder().begin(), cmdl.remainder().end());
+    CHECK(build["release"]);
+    CHECK("build" == build[0]);
+    CHECK("target" == build[1]);
+    CHECK(2 == build.remainder().size());
+    CHECK("run" == *build.remainder().begin());
+
+    // a subcommand name is not a boundary when it is the first arg, or a param value
+    const char* first[] = { "build", "--jobs", "run", nullptr };
+    cmdl.parse(first);
+    CHECK(0 == cmdl.remainder().size());
+    CHECK("run" == cmdl("jobs").str());
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    // a view_parser refers into the strings it parses
+    view_parser view;
+    view.parse(cmdl.pos_args().begin(), cmdl.pos_args().end());
+    CHECK(cmdl[0].data() == view[0].data());
+
+    view.add_subcommand("build");
+    view.parse(argv);
+    view_parser sub;
+    sub.parse(view.remainder().begin(), view.remainder().end(), parser::PREFER_PARAM_FOR_UNREG_OPTION);
+    CHECK(argv[6] == sub("release").str());
+    CHECK(argv[6] == sub.params().begin()->second.data());
+#endif
+}
+
+TEST_CASE("Test key handles")
+{
+    const char* argv[] = { "app", "-v", "--jobs", "4", "--out=a.txt", "--out=b.txt", "-q", "free", nullptr };
+
+    parser cmdl;
+    auto const jobs = cmdl.add_param("--jobs");
+    auto const out = cmdl.add_param("out");
+    auto const verbose = cmdl.add_flag("v");
+    auto const free = cmdl.add_flag("-q");
+    auto const missing = cmdl.add_param("missing");
+    CHECK(jobs);
+    CHECK(!argh::key());
+
+    // registering a name again returns the same key
+    auto const again = cmdl.add_params("jobs");
+    cmdl.parse(argv, parser::PREFER_PARAM_FOR_UNREG_OPTION);
+    CHECK("4" == cmdl(again).str());
+
+    CHECK(cmdl[verbose]);
+    CHECK(cmdl[free]);
+    CHECK(!cmdl[jobs]);
+    CHECK(!cmdl[argh::key()]);
+    CHECK("4" == cmdl(jobs).str());
+    CHECK(4 == cmdl.get<int>(jobs).value());
+    CHECK("a.txt" == cmdl(out).str()); // the first value, like cmdl("out")
+    CHECK(!cmdl(missing));
+    CHECK("8" == cmdl(missing, 8).str());
+    CHECK(get_status::MISSING == cmdl.get<int>(missing).status());
+    CHECK(!cmdl(argh::key()));
+
+    // a declared flag does not take the next arg as its value, even under PREFER_PARAM_FOR_UNREG_OPTION
+    CHECK(2 == cmdl.size());
+    CHECK("free" == cmdl[1]);
+
+    // the keys follow reparse(), and the copies of the parser
+    const char* other[] = { "app", "--jobs", "2", nullptr };
+    cmdl.reparse(other);
+    CHECK(2 == cmdl.get<int>(jobs).value());
+    CHECK(!cmdl[verbose]);
+    CHECK(!cmdl(out));
+
+    auto copy = cmdl;
+    cmdl.parse(argv);
+    CHECK(2 == copy.get<int>(jobs).value());
+    CHECK(4 == cmdl.get<int>(jobs).value());
+    copy = cmdl;
+    CHECK(4 == copy.get<int>(jobs).value());
+    CHECK(copy[verbose]);
+
+    // a key registered after parsing is found by the next parse
+    auto const late = cmdl.add_param("late");
+    const char* later[] = { "app", "--late", "1", nullptr };
+    CHECK(!cmdl(late));
+    cmdl.parse(later);
+    CHECK(1 == cmdl.get<int>(late).value());
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    flat_view_parser view;
+    auto const view_jobs = view.add_param("jobs");
+    view.parse(argv);
+    CHECK(argv[3] == view(view_jobs).str());
+#endif
+}
+
+TEST_CASE("Test alias groups")
+{
+    const char* argv[] = { "app", "-t", "1", "--threshold", "2", "--thresh=3", "-V", "--verbose", nullptr };
+
+    parser cmdl;
+    auto const threshold = cmdl.add_params({ "t", "-thresh", "--threshold" }, "threshold");
+    auto const verbose = cmdl.add_flags({ "V", "verbose" }, "--verbose");
+    cmdl.parse(argv);
+
+    // every spelling is stored, and found, as the canonical name
+    CHECK(0 == cmdl.params().count("t"));
+    CHECK(3 == cmdl.params().count("threshold"));
+    CHECK(1 == cmdl.size());
+    CHECK(2 == cmdl.flags().count("verbose"));
+    CHECK(2 == cmdl.flags().size());
+
+    CHECK("1" == cmdl("-t").str());
+    CHECK("1" == cmdl({ "thresh", "threshold" }).str());
+    CHECK(1 == cmdl.get<int>("--thresh").value());
+    CHECK(1 == cmdl.get<int>(threshold).value());
+    CHECK(cmdl["V"]);
+    CHECK(cmdl[verbose]);
+
+    std::vector<std::string> values;
+    for (auto& param : cmdl.params("t"))
+        values.push_back(param.second);
+    CHECK((std::vector<std::string>{ "1", "2", "3" }) == values);
+
+    // a key added for an alias resolves to the canonical name
+    auto const t = cmdl.add_param("t");
+    cmdl.parse(argv);
+    CHECK(1 == cmdl.get<int>(t).value());
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    flat_view_parser view;
+    view.add_params({ "t", "thresh" }, "threshold");
+    view.parse(argv);
+    CHECK(3 == view.params("thresh").size());
+    CHECK(argv[2] == view("t").str());
+#endif
+}
+
+TEST_CASE("Test value_or(...)")
+{
+    const char* argv[] = { "app", "--scale=0.1", "-j", "4", "--name", "x y", "--bad=1.5", "12", nullptr };
+
+    parser cmdl({ "j", "name" });
+    auto const scale = cmdl.add_param("scale");
+    cmdl.parse(argv);
+
+    CHECK(0.1 == cmdl.value_or("scale", 2.0));
+    CHECK(0.1 == cmdl.value_or(scale, 2.0));
+    CHECK(4 == cmdl.value_or({ "-j", "--jobs" }, 1));
+    CHECK(std::string("x y") == cmdl.value_or("name", std::string("none")));
+    CHECK(12 == cmdl.value_or(1, 0));
+
+    // missing, or not converting: the default as is
+    double const third = 1.0 / 3.0;
+    CHECK(third == cmdl.value_or("missing", third));
+    CHECK(third == cmdl.value_or({ "m", "missing" }, third));
+    CHECK(third == cmdl.value_or(argh::key(), third));
+    CHECK(7 == cmdl.value_or("bad", 7));
+    CHECK(7 == cmdl.value_or(2, 7));
+    CHECK(std::string("none") == cmdl.value_or("missing", std::string("none")));
+
+    // string defaults: the arg as it is, in the string type of the parser
+    std::string const out = cmdl.value_or("name", "a.out");
+    CHECK("x y" == out);
+    CHECK("a.out" == cmdl.value_or("missing", "a.out"));
+    CHECK("1.5" == cmdl.value_or({ "m", "bad" }, "none"));
+    CHECK("none" == cmdl.value_or({ "m", "missing" }, "none"));
+    CHECK("12" == cmdl.value_or(1, "none"));
+    CHECK("none" == cmdl.value_or(2, "none"));
+    CHECK("0.1" == cmdl.value_or(scale, "1"));
+    CHECK("1" == cmdl.value_or(argh::key(), "1"));
+
+    auto job = cmdl.overlay();
+    job.set_param("name", "z");
+    CHECK("z" == job.value_or("name", "a.out"));
+    CHECK("a.out" == job.value_or("missing", "a.out"));
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    view_parser view({ "name" });
+    view.parse(argv);
+    static_assert(std::is_same<decltype(view.value_or("name", "")), std::string_view>::value, "");
+    CHECK(view.value_or("name", "").data() == argv[5]);
+    CHECK("a.out" == view.value_or("missing", "a.out"));
+#endif
+
+    wparser wide({ L"name" });
+    const wchar_t* wargv[] = { L"app", L"--name", L"w", nullptr };
+    wide.parse(wargv);
+    CHECK(L"w" == wide.value_or(L"name", L"none"));
+    CHECK(L"none" == wide.value_or(L"missing", L"none"));
+}
+
+TEST_CASE("Test get_list(...)")
+{
+    const char* argv[] = { "app", "--ids=1,2,3", "--shard", "4", "--ids", "-5", "--shard", "7", "--names=a;bc;d e", "--bad=1,x,3", nullptr };
+
+    parser cmdl({ "ids", "shard" });
+    cmdl.parse(argv);
+
+    // repeated params are merged in order of appearance
+    CHECK((std::vector<int>{ 1, 2, 3, -5 }) == cmdl.get_list<int>("ids").value());
+    CHECK((std::vector<int>{ 4, 7 }) == cmdl.get_list<int>("--shard").value());
+    CHECK((std::vector<std::string>{ "a", "bc", "d e" }) == cmdl.get_list<std::string>("names", ';').value());
+    CHECK(get_status::MISSING == cmdl.get_list<int>("missing").status());
+    CHECK(get_status::BAD_CONVERSION == cmdl.get_list<int>("bad").status());
+
+    // appended to the caller's vector
+    std::vector<long> out{ 0 };
+    CHECK(get_status::OK == cmdl.get_list("ids", out));
+    CHECK((std::vector<long>{ 0, 1, 2, 3, -5 }) == out);
+    CHECK(get_status::BAD_CONVERSION == cmdl.get_list("bad", out));
+    CHECK((std::vector<long>{ 0, 1, 2, 3, -5, 1 }) == out);
+
+    // long lists, with separators across the 8 byte blocks
+    std::string ids = "--ids=";
+    for (int i = 0; i < 1000; ++i)
+        ids += std::to_string(i * 37) + (i < 999 ? "," : "");
+    std::vector<double> doubles;
+    const char* long_argv[] = { "app", ids.c_str(), nullptr };
+    cmdl.parse(long_argv);
+    CHECK(get_status::OK == cmdl.get_list("ids", doubles));
+    REQUIRE(1000 == doubles.size());
+    CHECK(999 * 37 == doubles.back());
+    CHECK(37 * 500 == doubles[500]);
+}
+
+#if defined(ARGH_ENABLE_STATS)
+TEST_CASE("Test stats()")
+{
+    const char* argv[] = { "app", "-v", "--jobs", "4", "--out=a.txt", "-5", "a-positional-arg-longer-than-sso", nullptr };
+
+    parser cmdl;
+    auto const jobs = cmdl.add_param("jobs");
+    cmdl.parse(argv);
+
+    auto stats = cmdl.stats();
+    CHECK(3 == stats.positional_args); // the value of --jobs too
+    CHECK(1 == stats.negative_numbers);
+    CHECK(2 == stats.options);
+    CHECK(1 == stats.options_with_value);
+    CHECK(4 == stats.number_checks);
+    CHECK(0 == stats.lookups); // nothing is looked up by the parse, keys neither
+    CHECK(0 < stats.args_bytes);
+    CHECK(0 < stats.pos_args_bytes);
+    CHECK(0 < stats.flags_bytes);
+    CHECK(0 < stats.params_bytes);
+
+    CHECK(cmdl["v"]);
+    CHECK(!cmdl["missing"]);
+    CHECK(cmdl.get<int>(jobs));
+    CHECK(!cmdl.get<int>({ "x", "y" }));
+    stats = cmdl.stats();
+    CHECK(5 == stats.lookups);
+    CHECK(3 == stats.lookup_misses);
+
+    cmdl.parse(argv);
+    CHECK(0 == cmdl.stats().lookups);
+}
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+TEST_CASE("Test counting_resource tracing")
+{
+    const char* argv[] = { "app", "--a-long-parameter-name=a-long-parameter-value", nullptr };
+
+    struct trace { size_t allocated = 0, freed = 0; } calls;
+    {
+        counting_resource resource(std::pmr::new_delete_resource(), [](void* context, void*, size_t bytes, bool allocated)
+        {
+            auto& t = *static_cast<trace*>(context);
+            (allocated ? t.allocated : t.freed) += bytes;
+        }, &calls);
+
+        pmr_parser cmdl(&resource);
+        cmdl.parse(argv);
+        CHECK(0 < resource.allocations());
+        CHECK(resource.bytes_in_use() == calls.allocated - calls.freed);
+        CHECK(resource.bytes_in_use() <= resource.peak_bytes());
+        CHECK(cmdl.stats().params_bytes <= resource.bytes_in_use());
+    }
+    CHECK(calls.allocated == calls.freed);
+}
+#endif
+#endif
+
+static void set_test_env(const char* name, const char* value)
+{
+#if defined(_WIN32)
+    _putenv_s(name, value ? value : "");
+#else
+    if (value)
+        setenv(name, value, 1);
+    else
+        unsetenv(name);
+#endif
+}
+
+TEST_CASE("Test environment fallback")
+{
+    set_test_env("ARGH_TEST_MAX_JOBS", "8");
+    set_test_env("ARGH_TEST_LEVEL", "high");
+    set_test_env("ARGH_TEST_RATE", "2.5");
+    set_test_env("ARGH_TEST_T", "ignored"); // an alias is read as its canonical name
+
+    const char* argv[] = { "app", "--level", "low", nullptr };
+
+    parser cmdl;
+    auto const jobs = cmdl.add_param("max-jobs");
+    cmdl.add_params({ "level", "rate", "missing" });
+    cmdl.add_params({ "t" }, "threshold");
+    cmdl.set_env_prefix("ARGH_TEST_");
+    cmdl.parse(argv);
+
+    // the command line comes first
+    CHECK("low" == cmdl("level").str());
+    CHECK("8" == cmdl("max-jobs").str());
+    CHECK(8 == cmdl.get<int>("--max-jobs").value());
+    CHECK(8 == cmdl.get<int>(jobs).value());
+    CHECK(8 == cmdl.value_or(jobs, 1));
+    CHECK(2.5 == cmdl.value_or("rate", 0.0));
+    CHECK(!cmdl("missing"));
+    CHECK(!cmdl("t"));
+    CHECK("none" == cmdl("threshold", "none").str());
+
+    // only the command line is in params()
+    CHECK(1 == cmdl.params().size());
+    CHECK(0 == cmdl.params().count("max-jobs"));
+
+    // the values are read by the parse, and stay valid in the copies
+    set_test_env("ARGH_TEST_MAX_JOBS", "16");
+    parser copy(cmdl);
+    CHECK(8 == copy.get<int>(jobs).value());
+    CHECK("2.5" == copy("rate").str());
+    cmdl.parse(argv);
+    CHECK(16 == cmdl.get<int>(jobs).value());
+    CHECK(8 == copy.get<int>("max-jobs").value());
+
+    // without a prefix, the environment is not read
+    parser plain;
+    plain.add_param("max-jobs");
+    plain.parse(argv);
+    CHECK(!plain("max-jobs"));
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    view_parser view;
+    view.add_param("max-jobs");
+    view.set_env_prefix("ARGH_TEST_");
+    view.parse(argv);
+    CHECK(16 == view.get<int>("max-jobs").value());
+#endif
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+    // reparsing refills the snapshot in place, unless a copy still refers to it
+    counting_resource resource;
+    pmr_parser pooled(&resource);
+    pooled.add_params({ "max-jobs", "level", "rate" });
+    pooled.set_env_prefix("ARGH_TEST_");
+    pooled.reparse(argv);
+    pooled.reparse(argv);
+    auto const allocations = resource.allocations();
+    for (int i = 0; i < 10; ++i)
+        pooled.reparse(argv);
+    CHECK(allocations == resource.allocations());
+    CHECK(16 == pooled.get<int>("max-jobs").value());
+
+    pmr_parser pooled_copy(pooled);
+    set_test_env("ARGH_TEST_MAX_JOBS", "32");
+    pooled.reparse(argv);
+    CHECK(32 == pooled.get<int>("max-jobs").value());
+    CHECK(16 == pooled_copy.get<int>("max-jobs").value());
+    CHECK(2.5 == pooled_copy.value_or("rate", 0.0));
+#endif
+
+    set_test_env("ARGH_TEST_MAX_JOBS", nullptr);
+    set_test_env("ARGH_TEST_LEVEL", nullptr);
+    set_test_env("ARGH_TEST_RATE", nullptr);
+    set_test_env("ARGH_TEST_T", nullptr);
+}
+
+TEST_CASE("Test add_source(...)")
+{
+    temp_file base("argh_test_base.conf", "# defaults\n  level = 1 \r\nname=base\n\n--rate=0.5\nbroken line\n; comment=x\nname=last wins\n=empty key\nempty=\n");
+    temp_file site("argh_test_site.conf", "level=2\nsite=yes");
+
+    set_test_env("ARGH_TEST_RATE", "2.5");
+
+    const char* argv[] = { "app", "--site", "cmd", nullptr };
+
+    parser cmdl;
+    auto const level = cmdl.add_param("level");
+    CHECK(cmdl.add_source("argh_test_base.conf"));
+    CHECK(cmdl.add_source("argh_test_site.conf"));
+    CHECK(!cmdl.add_source("argh_test_missing.conf"));
+    cmdl.add_params({ "site", "rate" });
+    cmdl.set_env_prefix("ARGH_TEST_");
+    cmdl.parse(argv);
+
+    // the command line, then the environment, then the last source, then the first
+    CHECK("cmd" == cmdl("site").str());
+    CHECK(2.5 == cmdl.value_or("rate", 0.0));
+    CHECK(2 == cmdl.get<int>(level).value());
+    CHECK("last wins" == cmdl("name").str());
+    CHECK(cmdl("empty"));
+    CHECK(cmdl("empty").str().empty());
+    CHECK(!cmdl("broken line"));
+    CHECK(!cmdl("comment"));
+    CHECK(!cmdl(""));
+    CHECK(0 == cmdl.params().count("level"));
+
+    // the sources are shared by the copies
+    parser copy(cmdl);
+    CHECK("base" != copy("name").str());
+    CHECK(2 == copy.get<int>("level").value());
+
+    set_test_env("ARGH_TEST_RATE", nullptr);
+    cmdl.parse(argv);
+    CHECK(0.5 == cmdl.value_or("rate", 0.0));
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    view_parser view;
+    view.add_source("argh_test_site.conf");
+    view.parse(argv);
+    CHECK("yes" == view("site").str());
+    CHECK("2" == view("level").str());
+#endif
+
+    wparser wide;
+    CHECK(!wide.add_source("argh_test_site.conf"));
+}
+
+#if defined(ARGH_HAS_STRING_VIEW)
+TEST_CASE("Test serialize() and frozen_parser")
+{
+    temp_file source("argh_test_frozen.conf", "rate=0.5\nname=base\n");
+
+    const char* argv[] = { "app", "-v", "--level", "3", "--level=4", "-xx", "in.txt", "--name", "", "run", "--fast", nullptr };
+
+    parser cmdl;
+    cmdl.add_params({ "level", "name" });
+    cmdl.add_subcommand("run");
+    cmdl.add_source("argh_test_frozen.conf");
+    cmdl.parse(argv);
+
+    // a copy of the blob, as if it was mapped from a file
+    std::string const blob = cmdl.serialize();
+    std::vector<char> mapped(blob.begin(), blob.end());
+
+    frozen_parser frozen;
+    REQUIRE(frozen.attach(mapped.data(), mapped.size()));
+    CHECK(frozen["v"]);
+    CHECK(frozen["--xx"]);
+    CHECK(!frozen["level"]);
+    CHECK(!frozen["fast"]);
+    CHECK(3 == frozen.get<int>("level").value());
+    CHECK("3" == frozen("--level").str());
+    CHECK(frozen("name"));
+    CHECK(frozen("name").str().empty());
+    CHECK(0.5 == frozen.get<double>("rate").value());
+    CHECK(get_status::MISSING == frozen.get<int>("missing").status());
+    CHECK(get_status::BAD_CONVERSION == frozen.get<int>("name").status());
+
+    CHECK(2 == frozen.size());
+    CHECK("app" == frozen[0]);
+    CHECK("in.txt" == frozen[1]);
+    CHECK(frozen[2].empty());
+    CHECK(!frozen(2));
+    CHECK(2 == frozen.remainder_size());
+    CHECK("run" == frozen.remainder(0));
+    CHECK("--fast" == frozen.remainder(1));
+
+    // anything but a whole snapshot is rejected
+    frozen_parser bad;
+    CHECK(!bad.attach(mapped.data(), mapped.size() - 1));
+    CHECK(!bad.attach(nullptr, 0));
+    mapped[0] ^= 1;
+    CHECK(!bad.attach(mapped.data(), mapped.size()));
+    CHECK(!bad["v"]);
+    CHECK(0 == bad.size());
+
+    parser empty;
+    auto const empty_blob = empty.serialize();
+    CHECK(frozen.attach(empty_blob.data(), empty_blob.size()));
+    CHECK(0 == frozen.size());
+    CHECK(!frozen["v"]);
+    CHECK(!frozen("level"));
+
+    // the refs and counts are 32-bit: larger ones fail instead of wrapping around
+    argh::detail::frozen_writer writer;
+    CHECK_NOTHROW(writer.set_count(argh::detail::frozen_format::flag_count, UINT32_MAX));
+    if (UINT32_MAX < SIZE_MAX)
+        CHECK_THROWS_AS(writer.set_count(argh::detail::frozen_format::flag_count, size_t(UINT32_MAX) + 1), std::length_error);
+}
+#endif
+
+#if defined(ARGH_HAS_STRING_VIEW)
+TEST_CASE("Test freeze()")
+{
+    temp_file source("argh_test_freeze.conf", "rate=0.5\nlevel=9\n");
+
+    const char* argv[] = { "app", "-v", "-v", "--level", "3", "--level=4", "-b", "in.txt", nullptr };
+
+    parser cmdl;
+    cmdl.add_param("level");
+    cmdl.add_source("argh_test_freeze.conf");
+    cmdl.parse(argv);
+
+    std::shared_ptr<frozen_parser const> const frozen = cmdl.freeze();
+    REQUIRE(frozen);
+    CHECK((*frozen)["v"]);
+    CHECK((*frozen)["-b"]);
+    CHECK(!(*frozen)["level"]);
+    CHECK(3 == frozen->get<int>("level").value());
+    CHECK(0.5 == frozen->get<double>("--rate").value());
+    CHECK(!(*frozen)("missing"));
+    CHECK(2 == frozen->size());
+    CHECK("in.txt" == (*frozen)[1]);
+
+    // the frozen parser is independent of the parser, and read by many threads at once
+    cmdl.parse(0, nullptr);
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+        readers.emplace_back([&]
+        {
+            for (int i = 0; i < 1000; ++i)
+                if (!(*frozen)["v"] || 3 != frozen->get<int>("level").value() || (*frozen)["x"] || "app" != (*frozen)[0])
+                    ++mismatches;
+        });
+    for (auto& reader : readers)
+        reader.join();
+    CHECK(0 == mismatches);
+
+    CHECK(!frozen_parser::make("not a snapshot"));
+    auto const empty = parser().freeze();
+    REQUIRE(empty);
+    CHECK(!(*empty)["v"]);
+    CHECK(!(*empty)("level"));
+}
+#endif
+
+TEST_CASE("Test incremental_parser")
+{
+    std::vector<std::vector<std::string>> const lines = {
+        { "app", "-v", "--level", "3", "in.txt", "--name=x", "-abc", "-5", "--last" },
+        { "app", "--level", "--", "-x", "tail" },
+        { "app", "pos", "run", "--fast", "now" },
+        { "app", "--level", "run" },
+        { "app", "", "--opt", "", "-" },
+        { "app" },
+    };
+
+    for (int mode : { int(parser::PREFER_FLAG_FOR_UNREG_OPTION), parser::PREFER_PARAM_FOR_UNREG_OPTION | parser::SINGLE_DASH_IS_MULTIFLAG | parser::DOUBLE_DASH_ENDS_OPTIONS })
+    {
+        for (auto const& line : lines)
+        {
+            parser expected;
+            expected.add_param("level");
+            expected.add_subcommand("run");
+            expected.parse(line.begin(), line.end(), mode);
+
+            std::string payload;
+            for (auto const& arg : line)
+                payload.append(arg).push_back('\0');
+
+            // fed in chunks of every size, the last arg terminated or not
+            for (size_t chunk = 1; chunk <= payload.size(); ++chunk)
+            {
+                for (bool terminated : { true, false })
+                {
+                    auto const size = terminated ? payload.size() : payload.size() - 1;
+                    incremental_parser incremental(mode);
+                    incremental.target().add_param("level");
+                    incremental.target().add_subcommand("run");
+                    for (size_t first = 0; first < size; first += chunk)
+                        incremental.feed(payload.data() + first, std::min(chunk, size - first));
+                    parser const& cmdl = incremental.finish();
+
+                    INFO("line ", line.size(), " chunk ", chunk, " mode ", mode);
+                    CHECK(expected.flags() == cmdl.flags());
+                    CHECK(expected.params() == cmdl.params());
+                    CHECK(expected.pos_args() == cmdl.pos_args());
+                    REQUIRE(expected.remainder().size() == cmdl.remainder().size());
+                    CHECK(std::equal(expected.remainder().begin(), expected.remainder().end(), cmdl.remainder().begin()));
+                }
+            }
+        }
+    }
+
+    incremental_parser incremental;
+    auto const jobs = incremental.target().add_param("jobs");
+    incremental.feed("app\0--jo", 8);
+    incremental.feed("bs\0", 3);
+    incremental.feed("4", 1);
+    auto& cmdl = incremental.finish();
+    CHECK(4 == cmdl.get<int>(jobs).value());
+    CHECK(1 == cmdl.size());
+    CHECK(&cmdl == &incremental.finish());
+}
+
+#if defined(ARGH_HAS_STRING_VIEW)
+TEST_CASE("Test visit(...)")
+{
+    struct recorder
+    {
+        std::multiset<std::string> flags;
+        std::multimap<std::string, std::string> params;
+        std::vector<std::string> pos_args;
+        std::vector<std::string> events;
+        void on_flag(std::string_view name)                          { flags.emplace(name); events.push_back("f:" + std::string(name)); }
+        void on_param(std::string_view name, std::string_view value) { params.emplace(name, value); events.push_back("p:" + std::string(name)); }
+        void on_positional(std::string_view arg)                     { pos_args.emplace_back(arg); events.push_back("a:" + std::string(arg)); }
+    };
+
+    const char* argv[] = { "app", "-v", "--level", "3", "-abt", "7", "--name=x", "-5", "in.txt", "--", "--after", "--last", nullptr };
+    int const argc = sizeof(argv) / sizeof(argv[0]) - 1;
+
+    for (int mode = 0; mode < 64; ++mode)
+    {
+        if ((mode & parser::PREFER_FLAG_FOR_UNREG_OPTION) && (mode & parser::PREFER_PARAM_FOR_UNREG_OPTION))
+            continue;
+        if (mode & parser::EXPAND_RESPONSE_FILES)
+            continue;
+
+        parser expected({ "level", "t" });
+        expected.parse(argc, argv, mode);
+
+        recorder visited;
+        auto const remainder = visit(argc, argv, mode, visited, { "level", "t" });
+
+        INFO("mode ", mode);
+        CHECK(std::equal(expected.flags().begin(), expected.flags().end(), visited.flags.begin(), visited.flags.end()));
+        CHECK(expected.params() == visited.params);
+        CHECK(expected.pos_args() == visited.pos_args);
+        CHECK(expected.remainder().size() == static_cast<size_t>(argc - remainder));
+    }
+
+    // the events come in order of appearance
+    recorder visited;
+    CHECK(10 == visit(argc, argv, parser::SINGLE_DASH_IS_MULTIFLAG | parser::DOUBLE_DASH_ENDS_OPTIONS, visited, { "level", "t" }));
+    CHECK((std::vector<std::string>{ "a:app", "f:v", "p:level", "f:a", "f:b", "p:t", "p:name", "a:-5", "a:in.txt" }) == visited.events);
+
+    recorder none;
+    CHECK(0 == visit(0, argv, parser::PREFER_FLAG_FOR_UNREG_OPTION, none));
+    CHECK(none.events.empty());
+}
+#endif
+
+TEST_CASE("Test single-char flags")
+{
+    const char* argv[] = { "app", "-xvf", "-v", "--verbose", "-V", "-é", "--ab", "-vv", nullptr };
+
+    parser cmdl;
+    cmdl.add_flags({ "V" }, "verbose");
+    cmdl.parse(argv, parser::SINGLE_DASH_IS_MULTIFLAG);
+
+    CHECK(cmdl["x"]);
+    CHECK(cmdl["-v"]);
+    CHECK(cmdl["f"]);
+    CHECK(!cmdl["a"]);
+    CHECK(cmdl["ab"]);
+    CHECK(cmdl["V"]);
+    CHECK(cmdl["verbose"]);
+    CHECK(4 == cmdl.flags().count("v"));
+    CHECK(2 == cmdl.flags().count("verbose"));
+    CHECK(0 == cmdl.flags().count("V"));
+    CHECK(1 == cmdl.flags().count("\xC3")); // the bytes of a multi-byte char are flags of their own
+    CHECK(11 == cmdl.flags().size());
+    CHECK(std::is_sorted(cmdl.flags().begin(), cmdl.flags().end()));
+
+    // the flags of the last parse only
+    const char* other[] = { "app", "-q", nullptr };
+    cmdl.reparse(other);
+    CHECK(cmdl["q"]);
+    CHECK(!cmdl["v"]);
+    CHECK(1 == cmdl.flags().size());
+    parser copy(cmdl);
+    CHECK(copy["q"]);
+    cmdl.parse(0, nullptr);
+    CHECK(!cmdl["q"]);
+    CHECK(copy["q"]);
+
+    wparser wide;
+    const wchar_t* wargv[] = { L"app", L"-ab", L"-\x263A", nullptr };
+    wide.parse(wargv, parser::SINGLE_DASH_IS_MULTIFLAG);
+    CHECK(wide[L"a"]);
+    CHECK(wide[L"\x263A"]);
+    CHECK(3 == wide.flags().size());
+
+    flat_parser flat(argv, parser::SINGLE_DASH_IS_MULTIFLAG);
+    CHECK(4 == flat.flags().count("v"));
+    CHECK(flat["V"]);
+}
+
+#if defined(ARGH_HAS_MEMORY_RESOURCE)
+TEST_CASE("Test single-char flags are counted, not stored, by the parse")
+{
+    const char* one[] = { "app", "-v", nullptr };
+    const char* many[] = { "app", "-vvvvvvvvvvvv", "-v", "-v", nullptr }; // the args fit in small strings
+
+    counting_resource resource;
+    auto allocations = [&](const char** argv)
+    {
+        pmr_parser cmdl(&resource);
+        auto const before = resource.allocations();
+        cmdl.parse(argv, parser::SINGLE_DASH_IS_MULTIFLAG);
+        return resource.allocations() - before;
+    };
+    CHECK(allocations(one) == allocations(many)); // nothing per flag
+
+    pmr_parser cmdl(&resource);
+    cmdl.parse(many, parser::SINGLE_DASH_IS_MULTIFLAG);
+    auto const before = resource.allocations();
+    CHECK(cmdl["v"]);
+    CHECK(!cmdl["x"]);
+    REQUIRE(1 == cmdl.byte_flags().size());
+    CHECK('v' == *cmdl.byte_flags()[0].name);
+    CHECK(14 == cmdl.byte_flags()[0].count);
+    CHECK(before == resource.allocations());
+
+    // stored by the first call to flags()
+    CHECK(14 == cmdl.flags().count("v"));
+    CHECK(before < resource.allocations());
+    cmdl.parse(one, parser::SINGLE_DASH_IS_MULTIFLAG);
+    CHECK(1 == cmdl.flags().size());
+}
+#endif
+
+TEST_CASE("Test single-char canonical flag aliases")
+{
+    const char* argv[] = { "app", "--verbose", "--quiet", nullptr };
+
+    parser cmdl;
+    cmdl.add_flags({ "verbose" }, "v");
+    cmdl.parse(argv);
+    CHECK(cmdl["v"]);
+    CHECK(cmdl["verbose"]);
+    CHECK(cmdl[{ "-x", "--verbose" }]);
+    CHECK(1 == cmdl.flags().count("v"));
+    CHECK(0 == cmdl.flags().count("verbose"));
+    CHECK(cmdl["quiet"]);
+
+    flat_parser flat;
+    flat.add_flags({ "verbose" }, "v");
+    flat.parse(argv);
+    CHECK(flat["v"]);
+    CHECK(flat["verbose"]);
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    view_parser view;
+    auto const v = view.add_flags({ "verbose" }, "v");
+    view.parse(argv);
+    CHECK(view["v"]);
+    CHECK(view["verbose"]);
+    CHECK(view[v]);
+    CHECK(*view.flags().begin() == "quiet");
+#endif
+}
+
+static uint64_t fingerprint(std::vector<std::string> const& args, std::initializer_list<char const* const> excluded = {})
+{
+    parser cmdl;
+    cmdl.add_params({ "o" }, "out");
+    cmdl.add_param("jobs");
+    cmdl.exclude_from_fingerprint(excluded);
+    cmdl.parse(args.begin(), args.end(), parser::SINGLE_DASH_IS_MULTIFLAG);
+    return cmdl.fingerprint();
+}
+
+TEST_CASE("Test fingerprint()")
+{
+
+    auto const base = fingerprint({ "app", "-xv", "--out", "a.o", "--jobs=4", "in.c", "--debug" });
+    CHECK(0 != base);
+
+    // the options in any order, and any spelling of them
+    CHECK(base == fingerprint({ "app", "--debug", "--jobs", "4", "-v", "in.c", "-x", "-o=a.o" }));
+    CHECK(base == fingerprint({ "app", "-vx", "in.c", "--jobs=4", "--o", "a.o", "--debug" }));
+
+    // but not other options, values or positional args
+    CHECK(base != fingerprint({ "app", "-xv", "--out", "a.o", "--jobs=4", "in.c" }));
+    CHECK(base != fingerprint({ "app", "-xvv", "--out", "a.o", "--jobs=4", "in.c", "--debug" }));
+    CHECK(base != fingerprint({ "app", "-xv", "--out", "b.o", "--jobs=4", "in.c", "--debug" }));
+    CHECK(base != fingerprint({ "app", "-xv", "--out=a.o", "--jobs=4", "in.c", "--debug", "in.c" }));
+    CHECK(fingerprint({ "app", "a", "b" }) != fingerprint({ "app", "b", "a" }));
+    // the values of a repeated param in order, as p(name) is the first one
+    CHECK(fingerprint({ "app", "--out", "a", "--out", "b" }) != fingerprint({ "app", "--out", "b", "--out", "a" }));
+    CHECK(fingerprint({ "app", "--jobs=4", "--out", "a", "--out", "b" }) == fingerprint({ "app", "--out", "a", "--jobs=4", "-o", "b" }));
+    CHECK(fingerprint({ "app", "--out", "a", "--out", "b" }) != fingerprint({ "app", "--out", "a", "--out", "b", "--out", "a" }));
+    CHECK(fingerprint({ "app", "--out=ab" }) != fingerprint({ "app", "--outa=b" }));
+    CHECK(fingerprint({ "app", "-x" }) != fingerprint({ "app", "x" }));
+
+    // excluded names do not count
+    auto const excluded = fingerprint({ "app", "-xv", "--out", "a.o", "--jobs=4", "in.c", "--debug" }, { "jobs", "v", "-o" });
+    CHECK(excluded != base);
+    CHECK(excluded == fingerprint({ "app", "-x", "--jobs=8", "in.c", "--debug" }, { "jobs", "v", "-o" }));
+
+    // the same in every process and on every machine
+    CHECK(0xbe494fe82cb65593ULL == fingerprint({ "app", "-v", "--jobs", "4", "in.c" }));
+
+    parser empty;
+    parser other;
+    other.parse(0, nullptr);
+    CHECK(empty.fingerprint() == 0);
+    CHECK(other.fingerprint() != 0);
+}
+
+TEST_CASE("Test MATCH_UNIQUE_PREFIX")
+{
+    parser cmdl;
+    cmdl.add_params({ "t", "threads-count" }, "threads");
+    cmdl.add_param("output");
+    cmdl.add_param("out");
+    cmdl.add_flags({ "V" }, "verbose");
+    cmdl.add_flag("version");
+
+    std::vector<char const*> const args{ "app", "--thr", "4", "--outp=a.o", "--verb", "--ver", "--in=x", "--out", "b", "--o" };
+    cmdl.parse(args.begin(), args.end(), parser::MATCH_UNIQUE_PREFIX);
+
+    // abbreviations are stored under the registered name, alias groups counted once
+    CHECK(cmdl("threads").str() == "4");
+    CHECK(cmdl("threads-count").str() == "4");
+    CHECK(cmdl("output").str() == "a.o");
+    CHECK(cmdl["verbose"]);
+    CHECK(cmdl["V"]);
+    CHECK(!cmdl["version"]);
+    CHECK(!cmdl("thr"));
+
+    // an exact name wins over longer names, an ambiguous abbreviation stays as typed
+    CHECK(cmdl("out").str() == "b");
+    CHECK(cmdl["ver"]);
+    CHECK(cmdl["o"]);
+    CHECK(cmdl("in").str() == "x");
+    CHECK(cmdl.size() == 1);
+
+    CHECK((cmdl.candidates("ver") == std::vector<std::string>{ "verbose", "version" }));
+    CHECK((cmdl.candidates("--out") == std::vector<std::string>{ "out", "output" }));
+    CHECK((cmdl.candidates("").size() == 8));
+    CHECK(cmdl.candidates("x").empty());
+
+    // off by default
+    cmdl.parse(args.begin(), args.end());
+    CHECK(!cmdl("threads"));
+    CHECK(cmdl["thr"]);
+    CHECK(cmdl["verb"]);
+    CHECK((cmdl.candidates("thr") == std::vector<std::string>{ "threads", "threads-count" }));
+
+    // and in chunks
+    incremental_parser chunks(parser::MATCH_UNIQUE_PREFIX);
+    chunks.target().add_param("threads");
+    chunks.feed("app\0--th\0" "8\0", 12);
+    CHECK(chunks.finish()("threads").str() == "8");
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    // a view parser keeps the expanded names, even when registering more moves the registered ones
+    char const* argv[] = { "app", "--thr", "5", "--verb", nullptr };
+    flat_view_parser view;
+    view.add_param("threshold");
+    view.add_flag("verbose");
+    view.parse(argv, parser::MATCH_UNIQUE_PREFIX);
+    std::vector<std::string> more;
+    for (int i = 0; i < 40; ++i)
+        more.push_back("param-" + std::to_string(i));
+    for (auto const& name : more)
+    {
+        view.add_param(name);
+        view.add_flag(name + "-flag");
+    }
+    CHECK(view.params().begin()->first == "threshold");
+    CHECK(*view.flags().begin() == "verbose");
+    CHECK(view("threshold").str() == "5");
+
+    auto const copy = std::make_shared<flat_view_parser>(view);
+    view = flat_view_parser();
+    CHECK(copy->params().begin()->first == "threshold");
+#endif
+}
+
+#if defined(ARGH_HAS_STRING_VIEW)
+TEST_CASE("Test pooled_parser owns its args")
+{
+    pooled_parser cmdl;
+    cmdl.add_param("o");
+    {
+        std::vector<std::string> args{ "app", "-v", "--out=a.o", "-o", "b.o", "in.c", "--", "rest" };
+        cmdl.parse(args.begin(), args.end(), parser::DOUBLE_DASH_ENDS_OPTIONS);
+        for (auto& arg : args)
+            arg.assign(arg.size(), '#');
+    }
+
+    CHECK(cmdl[0] == "app");
+    CHECK(cmdl[1] == "in.c");
+    CHECK(cmdl["v"]);
+    CHECK(cmdl("out").str() == "a.o");
+    CHECK(cmdl("o").str() == "b.o");
+    CHECK(*cmdl.remainder().begin() == "rest");
+
+    // one buffer, in order, each arg '\0'-terminated
+    CHECK(cmdl[1].data() > cmdl[0].data());
+    CHECK(cmdl.flags().begin()->data() == cmdl[0].data() + 4 + 1);
+    CHECK(cmdl[0].data()[cmdl[0].size()] == '\0');
+
+    // moved, it still refers into its own buffer; a copy would not, so there is none
+    static_assert(!std::is_copy_constructible<pooled_parser>::value && !std::is_copy_assignable<pooled_parser>::value, "");
+    static_assert(std::is_nothrow_move_constructible<pooled_parser>::value == std::is_nothrow_move_constructible<view_parser>::value, "");
+    static_assert(std::is_copy_constructible<view_parser>::value && std::is_copy_constructible<parser>::value, "");
+    auto moved = std::move(cmdl);
+    CHECK(moved[1] == "in.c");
+    CHECK(moved("o").str() == "b.o");
+
+    char const* argv[] = { "app", "-x", "--jobs", "4", nullptr };
+    std::string copies[] = { "app", "-x", "--jobs", "4" };
+    pooled_parser from_argv(argv, parser::PREFER_PARAM_FOR_UNREG_OPTION);
+    moved.reparse(4, argv, parser::PREFER_PARAM_FOR_UNREG_OPTION);
+    pooled_parser assigned;
+    assigned = std::move(moved);
+    moved = std::move(assigned);
+    for (auto const* parsed : { &from_argv, &moved })
+    {
+        CHECK(parsed->size() == 1);
+        CHECK((*parsed)[0].data() != argv[0]);
+        CHECK((*parsed)("jobs").str() == "4");
+        CHECK((*parsed)["x"]);
+    }
+    CHECK(copies[2] == argv[2]);
+}
+
+TEST_CASE("Test pooled_parser matches parser")
+{
+    std::vector<char const*> const args{ "app", "-d", "-f", "123", "-g", "456", "-e", "--foo=1", "--foo=2", "-1.5", "-xvf" };
+    for (int mode : { int(parser::PREFER_FLAG_FOR_UNREG_OPTION), int(parser::PREFER_PARAM_FOR_UNREG_OPTION), int(parser::SINGLE_DASH_IS_MULTIFLAG) })
+    {
+        parser owning({ "g" });
+        pooled_parser pooled({ "g" });
+        flat_pooled_parser flat({ "g" });
+        owning.parse(args.begin(), args.end(), mode);
+        pooled.parse(args.begin(), args.end(), mode);
+        flat.parse(static_cast<int>(args.size()), args.data(), mode);
+
+        CHECK(std::vector<std::string>(pooled.begin(), pooled.end()) == owning.pos_args());
+        CHECK(std::multiset<std::string>(pooled.flags().begin(), pooled.flags().end()) == owning.flags());
+        CHECK(std::multimap<std::string, std::string>(pooled.params().begin(), pooled.params().end()) == owning.params());
+        CHECK(std::vector<std::string>(flat.begin(), flat.end()) == owning.pos_args());
+        CHECK(std::multimap<std::string, std::string>(flat.params().begin(), flat.params().end()) == owning.params());
+        CHECK(pooled.fingerprint() == owning.fingerprint());
+    }
+}
+#endif
+
+TEST_CASE("Test overlay()")
+{
+    parser cmdl;
+    cmdl.add_params({ "j" }, "jobs");
+    cmdl.add_param("o");
+    char const* argv[] = { "app", "-v", "--jobs", "4", "-o", "a.o", "-o", "b.o", "in.c", nullptr };
+    cmdl.parse(argv);
+
+    auto job = cmdl.overlay();
+    CHECK(&job.base() == &cmdl);
+    CHECK(job["v"]);
+    CHECK(job.get<int>("jobs").value() == 4);
+    CHECK(job.size() == 2);
+
+    job.set_param("--j", "8");
+    job.set_param("o", "c.o");
+    job.set_param("new", "1");
+    job.set_flag("v", false);
+    job.set_flag("-q");
+    job.add_pos_arg("extra.c");
+
+    // changes first, aliases and dashes as in the base
+    CHECK(job.get<int>("jobs").value() == 8);
+    CHECK(job.value_or("j", 0) == 8);
+    CHECK(job("o").str() == "c.o");
+    CHECK(job.get<int>("new").value() == 1);
+    CHECK(!job["v"]);
+    CHECK(job["q"]);
+    CHECK(job.size() == 3);
+    CHECK(job[1] == "in.c");
+    CHECK(job[2] == "extra.c");
+    CHECK(job[3].empty());
+    CHECK(job(2).str() == "extra.c");
+    CHECK(!job.get<int>(2));
+    CHECK(get_status::MISSING == job.get<int>("missing").status());
+
+    // then the base, unchanged and shared
+    CHECK(job.get<std::string>(0).value() == "app");
+    CHECK(job.value_or("missing", 5) == 5);
+    CHECK(cmdl.get<int>("jobs").value() == 4);
+    CHECK(cmdl.params("o").size() == 2);
+    CHECK(cmdl["v"]);
+    CHECK(!cmdl["q"]);
+    CHECK(cmdl.size() == 2);
+
+    auto other = cmdl.overlay();
+    other.set_param("jobs", "1");
+    other.set_param("jobs", "2");
+    CHECK(other.get<int>("j").value() == 2);
+    CHECK(job.get<int>("j").value() == 8);
+    CHECK(other["v"]);
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    // a view_parser overlay refers to the strings given to it
+    view_parser view({ "jobs" });
+    view.parse(argv);
+    std::string const jobs = "16";
+    auto viewed = view.overlay();
+    viewed.set_param("jobs", jobs);
+    CHECK(viewed.get<int>("jobs").value() == 16);
+    CHECK(viewed("jobs").str() == "16");
+    CHECK(viewed[0].data() == argv[0]);
+#endif
+}
+
+TEST_CASE("Test overlay() accessors")
+{
+    parser cmdl;
+    auto const jobs = cmdl.add_params({ "j" }, "jobs");
+    auto const verbose = cmdl.add_flag("verbose");
+    cmdl.add_param("ids");
+    char const* argv[] = { "app", "--verbose", "-j", "4", "--ids=1,2", "--ids", "3", "in.c", nullptr };
+    cmdl.parse(argv);
+
+    auto job = cmdl.overlay();
+    job.set_param("jobs", "8");
+    job.set_flag("verbose", false);
+    job.set_flag("q");
+
+    // alias groups: the first name found, in the changes or the base
+    CHECK(job[{ "x", "q" }]);
+    CHECK(!job[{ "x", "verbose" }]);
+    CHECK("8" == job({ "x", "j" }).str());
+    CHECK("1,2" == job({ "x", "ids" }).str());
+    CHECK(!job({ "x", "y" }));
+    CHECK(8 == job.get<int>({ "x", "j" }).value());
+    CHECK(get_status::MISSING == job.get<int>({ "x", "y" }).status());
+    CHECK(8 == job.value_or({ "x", "j" }, 0));
+    CHECK("none" == job.value_or({ "x", "y" }, "none"));
+
+    // keys
+    CHECK(!job[verbose]);
+    CHECK(cmdl[verbose]);
+    CHECK("8" == job(jobs).str());
+    CHECK(8 == job.get<int>(jobs).value());
+    CHECK(8 == job.value_or(jobs, 0));
+    CHECK("8" == job.value_or(jobs, "none"));
+    CHECK("2" == job(argh::key(), 2).str());
+
+    // defaults
+    CHECK("8" == job("j", 1).str());
+    CHECK("1" == job("missing", 1).str());
+    CHECK("1.5" == job({ "x", "y" }, 1.5).str());
+    CHECK("in.c" == job(1, "none").str());
+    CHECK("none" == job(2, "none").str());
+    CHECK(5 == job.value_or(2, 5));
+    CHECK("none" == job.value_or(2, "none"));
+
+    // lists
+    CHECK((std::vector<int>{ 1, 2, 3 } == job.get_list<int>("ids").value()));
+    std::vector<int> values;
+    CHECK(get_status::OK == job.get_list("j", values));
+    CHECK(std::vector<int>{ 8 } == values);
+    job.set_param("ids", "5,x");
+    CHECK(get_status::BAD_CONVERSION == job.get_list<int>("ids").status());
+    CHECK(get_status::MISSING == job.get_list<int>("missing").status());
+}
+
+TEST_CASE("Test overlay() views")
+{
+    parser cmdl;
+    cmdl.add_params({ "j" }, "jobs");
+    cmdl.add_param("o");
+    char const* argv[] = { "app", "-v", "-v", "--jobs", "4", "-o", "a.o", "-o", "b.o", "--quiet", "in.c", nullptr };
+    cmdl.parse(argv);
+
+    auto job = cmdl.overlay();
+    job.set_param("j", "8");
+    job.set_param("new", "1");
+    job.set_flag("v", false);
+    job.set_flag("debug");
+    job.set_flag("x", false);
+    job.add_pos_arg("extra.c");
+
+    // params: the changed names have only their new value
+    std::vector<std::pair<std::string, std::string>> params;
+    for (auto const& param : job.params())
+        params.emplace_back(param.first, param.second);
+    CHECK((std::vector<std::pair<std::string, std::string>>{ { "jobs", "8" }, { "new", "1" }, { "o", "a.o" }, { "o", "b.o" } } == params));
+    CHECK(4 == job.params().size());
+    CHECK("jobs" == job.params().begin()->first);
+
+    CHECK(1 == job.params("j").size());
+    CHECK("8" == job.params("jobs").begin()->second);
+    CHECK(2 == job.params("o").size());
+    CHECK("b.o" == std::next(job.params("-o").begin())->second);
+    CHECK(job.params("missing").empty());
+
+    // flags: those of the base not cleared, and the ones set
+    std::vector<std::string> flags(job.flags().begin(), job.flags().end());
+    CHECK((std::vector<std::string>{ "debug", "quiet" } == flags));
+    CHECK(3 == cmdl.flags().size());
+
+    // positional args: those of the base, then the added ones
+    std::vector<std::string> pos_args(job.pos_args().begin(), job.pos_args().end());
+    CHECK((std::vector<std::string>{ "app", "in.c", "extra.c" } == pos_args));
+    std::vector<std::string> range_for;
+    for (auto const& arg : job)
+        range_for.push_back(arg);
+    CHECK(pos_args == range_for);
+    CHECK(job.size() == job.pos_args().size());
+
+    // an overlay without changes sees the base
+    auto same = cmdl.overlay();
+    CHECK(cmdl.params().size() == same.params().size());
+    CHECK(std::equal(cmdl.flags().begin(), cmdl.flags().end(), same.flags().begin()));
+    CHECK(std::equal(cmdl.begin(), cmdl.end(), same.begin()));
+
+    flat_parser flat({ "jobs", "o" });
+    flat.parse(argv);
+    auto flat_job = flat.overlay();
+    flat_job.set_param("o", "c.o");
+    CHECK(2 == flat_job.params().size());
+    CHECK("c.o" == std::next(flat_job.params().begin())->second);
+
+#if defined(ARGH_HAS_STRING_VIEW)
+    view_parser view({ "jobs" });
+    view.parse(argv);
+    auto viewed = view.overlay();
+    viewed.set_flag("v", false);
+    CHECK(3 == viewed.flags().size());
+    CHECK(viewed.params().begin()->second.data() == argv[4]);
+#endif
+}
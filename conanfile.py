@@ -8,8 +8,9 @@ class ArghConan(ConanFile):
     description = "Argh! A minimalist argument handler."
     license = "BSD 3-Clause"
     exports = ["LICENSE"]
-    exports_sources = "argh.h"
+    exports_sources = "argh.h", "argh_fwd.h", "wargh.h", "argh.cppm"
 
     def package(self):
         self.copy(pattern="LICENSE", dst="license")
-        self.copy(pattern="argh.h", dst="include")
+        self.copy(pattern="*.h", dst="include")
+        self.copy(pattern="argh.cppm", dst="include")